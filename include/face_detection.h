@@ -3,7 +3,33 @@
 
 #include <opencv2/opencv.hpp>
 
-// 人脸检测函数声明
+// 人脸检测参数
+struct DetectionParams {
+    double scale_factor = 1.1;            // 缩放因子
+    int min_neighbors = 3;                // 最小邻居数
+    cv::Size min_size = cv::Size(30, 30); // 最小人脸尺寸（原图坐标）
+    double input_scale = 1.0;             // 检测前的图像缩放比例（<1 时先缩小再检测）
+    bool equalize_hist = true;            // 是否进行直方图均衡化
+};
+
+// 级联分类器的实现
+enum class CascadeBackend {
+    FLAT,     // 项目内的扁平化级联（HaarCascade，CPU 支持时使用 AVX2 内核），需显式启用
+    OPENCV    // cv::CascadeClassifier，默认
+};
+
+// 选择检测使用的级联实现（进程级设置）；扁平化级联加载失败时回退到 OpenCV
+// 扁平化级联与 OpenCV 的一致性由 cascade_benchmark 校验，在pictures目录和回放帧日志上确认之前不作为默认
+void setCascadeBackend(CascadeBackend backend);
+CascadeBackend getCascadeBackend();
+
+// 预先解析人脸级联模型文件（进程内只解析一次，可在后台线程调用），之后各线程首次检测时不再解析XML
+bool preloadFaceCascade();
+
+// 人脸检测函数声明（frame 为BGR图像，或单通道灰度图/YUV帧的亮度平面，后者不做颜色转换）
 std::vector<cv::Rect> detectFaces(const cv::Mat& frame);
 
+// 使用指定参数检测人脸
+std::vector<cv::Rect> detectFaces(const cv::Mat& frame, const DetectionParams& params);
+
 #endif
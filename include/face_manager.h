@@ -1,9 +1,19 @@
 #pragma once
 
 #include <opencv2/opencv.hpp>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
+
+// 一个身份（人）及其所有注册样本
+struct FaceIdentity {
+    std::string label;
+    uint32_t label_id = 0;          // 标签在 LabelTable::global() 中的ID
+    cv::Mat centroid;               // 归一化样本的平均模板，用于第一轮粗筛
+    std::vector<cv::Mat> samples;   // 每张照片的模板，仅对候选身份进行比对
+};
 
 class FaceManager {
 public:
@@ -22,9 +32,21 @@ public:
     // 获取已注册的人脸标签
     const std::vector<std::string>& getKnownLabels() const;
     
-    // 获取注册的人脸数量
+    // 获取已注册的人脸标签ID（与 getKnownFeatures 一一对应，对应 LabelTable::global()）
+    const std::vector<uint32_t>& getKnownLabelIds() const;
+    
+    // 获取已注册的身份（每人一个条目，包含平均模板和全部样本）
+    const std::vector<FaceIdentity>& getIdentities() const;
+    
+    // 获取注册的人脸数量（样本数）
     size_t getRegisteredCount() const;
     
+    // 获取注册的身份数量（人数）
+    size_t getIdentityCount() const;
+    
+    // 将已注册的人脸导出为分层图库的冷层文件
+    bool exportGallery(const std::string& path) const;
+    
     // 检查是否已初始化
     bool isInitialized() const;
 
@@ -36,10 +58,22 @@ private:
     
     // 自动扫描pictures目录
     bool autoScanPicturesDirectory();
+    
+    // 读取标签映射文件（每行 "文件名 标签"）
+    std::unordered_map<std::string, std::string> loadLabelMapping(const std::string& mapping_path) const;
+    
+    // 为身份添加一个样本
+    void addSample(const std::string& label, const cv::Mat& features);
+    
+    // 计算每个身份的平均模板
+    void buildCentroids();
 
 private:
     std::string pictures_directory_;
     std::vector<cv::Mat> known_features_;
     std::vector<std::string> known_labels_;
+    std::vector<uint32_t> known_label_ids_;
+    std::vector<FaceIdentity> identities_;
+    std::unordered_map<std::string, size_t> identity_index_;
     bool initialized_;
 };
@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 
+class ThreadPool;
+
 class FaceRecognition {
 public:
     FaceRecognition();
@@ -20,6 +22,12 @@ public:
     cv::Mat extractFaceFeatures(const cv::Mat& faceImage);
     std::vector<cv::Mat> extractFaceFeatures(const cv::Mat& frame, const std::vector<cv::Rect>& faces);
     
+    // 批量特征提取：人脸缩放为连续的112x112图块，按人脸交错存放，统计量以人脸为向量通道计算
+    // 结果与输入一一对应（无法处理的人脸为空Mat）；pool 非空时各批分发到线程池并行
+    std::vector<cv::Mat> extractFaceFeaturesBatch(const std::vector<cv::Mat>& faceImages, ThreadPool* pool = nullptr);
+    std::vector<cv::Mat> extractFaceFeaturesBatch(const cv::Mat& frame, const std::vector<cv::Rect>& faces,
+                                                  ThreadPool* pool = nullptr);
+    
     // 人脸比较
     bool compareFaces(const cv::Mat& face1, const cv::Mat& face2, double threshold = 0.9);
 
@@ -34,11 +42,16 @@ private:
     // 私有方法
     cv::Mat preprocessFace(const cv::Mat& face);
     cv::Mat extractSimpleFeatures(const cv::Mat& processed);
+    cv::Mat finalizeFeatures(std::vector<float>& features) const;
+    void extractBatchGroup(const cv::Mat* const* faces, size_t count, cv::Mat* results) const;
 };
 
 // 便捷函数声明
 bool load_model();
 std::vector<cv::Mat> extract_face_features(const cv::Mat& frame, const std::vector<cv::Rect>& faces);
+std::vector<cv::Mat> extract_face_features_batch(const std::vector<cv::Mat>& faceImages, ThreadPool* pool = nullptr);
+std::vector<cv::Mat> extract_face_features_batch(const cv::Mat& frame, const std::vector<cv::Rect>& faces,
+                                                 ThreadPool* pool = nullptr);
 double compare_faces(const cv::Mat& face1, const cv::Mat& face2, double threshold = 0.9);
 
 #endif
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class ThreadPool;
+
+// 连续存储的特征矩阵：每行一个 L2 归一化后的特征（行优先），点积即余弦相似度
+class FeatureMatrix {
+public:
+    FeatureMatrix();
+    FeatureMatrix(size_t rows, int dimension);
+
+    // 由逐个 cv::Mat 特征构造（要求维度一致），并归一化每一行
+    static FeatureMatrix fromMats(const std::vector<cv::Mat>& features);
+
+    // 由行优先的连续数据构造，并归一化每一行
+    static FeatureMatrix fromRows(const float* data, size_t rows, int dimension);
+
+    size_t rows() const { return rows_; }
+    int dimension() const { return dimension_; }
+    bool empty() const { return rows_ == 0; }
+
+    const float* row(size_t index) const { return data_.data() + index * dimension_; }
+    float* row(size_t index) { return data_.data() + index * dimension_; }
+
+    // 将每一行归一化为单位长度（零向量保持不变）
+    void normalizeRows();
+
+private:
+    size_t rows_;
+    int dimension_;
+    std::vector<float> data_;
+};
+
+// 相似度超过阈值的一对特征（i < j）
+struct SimilarPair {
+    uint32_t i;
+    uint32_t j;
+    float similarity;
+};
+
+// 全对相似度统计
+struct AllPairsStats {
+    uint64_t tiles = 0;
+    uint64_t pairs_compared = 0;
+    uint64_t pairs_reported = 0;
+    double seconds = 0.0;
+    double gflops = 0.0;
+};
+
+// 计算一个块：a 的 [a_begin, a_end) 行与 b 的 [b_begin, b_end) 行两两点积，
+// 结果写入 out（(a_end - a_begin) × (b_end - b_begin)，行优先）
+void similarityTile(const FeatureMatrix& a, size_t a_begin, size_t a_end,
+                    const FeatureMatrix& b, size_t b_begin, size_t b_end,
+                    float* out);
+
+// 上三角分块遍历：将 matrix 划分为 block × block 的块（bi <= bj）在线程池上并行计算，
+// 每个块算完后在工作线程上调用 visit(a_begin, a_end, b_begin, b_end, scores)；对角块同样给出完整矩形，调用方只取 j > i
+typedef std::function<void(size_t a_begin, size_t a_end, size_t b_begin, size_t b_end,
+                           const float* scores)> TileVisitor;
+AllPairsStats forEachTile(const FeatureMatrix& matrix, ThreadPool& pool, const TileVisitor& visit,
+                          size_t block = 128);
+
+// 分块全对相似度：将上三角划分为 block × block 的块在线程池上并行计算，只输出相似度 ≥ threshold 的对
+// 每个块的结果批量交给 sink（持锁串行调用），不会构造完整的 N × N 矩阵
+AllPairsStats forEachSimilarPair(const FeatureMatrix& matrix,
+                                 float threshold,
+                                 ThreadPool& pool,
+                                 const std::function<void(const std::vector<SimilarPair>&)>& sink,
+                                 size_t block = 128);
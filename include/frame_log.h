@@ -0,0 +1,91 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// 帧日志中单帧的存储方式
+enum class FrameEncoding : uint32_t {
+    RAW = 0,   // 原始像素，按行连续存放；读取时直接映射为 cv::Mat，不复制
+    PNG = 1    // PNG 无损压缩，读取时解码
+};
+
+// 帧索引条目（文件末尾，按帧顺序排列）
+struct FrameLogEntry {
+    uint64_t timestamp_us;   // 相对第一帧的采集时间（微秒）
+    uint64_t offset;         // 帧数据在文件中的偏移
+    uint64_t size;           // 帧数据字节数
+    uint32_t width;
+    uint32_t height;
+    int32_t type;            // cv::Mat 类型（如 CV_8UC3）
+    uint32_t encoding;       // FrameEncoding
+};
+
+// 帧日志写入器：逐帧追加，close() 时写入索引并回填文件头
+class FrameLogWriter {
+public:
+    FrameLogWriter();
+    ~FrameLogWriter();
+
+    FrameLogWriter(const FrameLogWriter&) = delete;
+    FrameLogWriter& operator=(const FrameLogWriter&) = delete;
+
+    // 创建日志文件；png_level 为 PNG 压缩等级（0-9，仅 PNG 编码使用）
+    bool open(const std::string& path, FrameEncoding encoding, int png_level = 1);
+
+    // 追加一帧，timestamp_us 为相对第一帧的时间
+    bool write(const cv::Mat& frame, uint64_t timestamp_us);
+
+    // 写入索引并关闭文件（析构时自动调用）
+    bool close();
+
+    // 已写入的帧数与帧数据字节数
+    size_t frameCount() const { return entries_.size(); }
+    uint64_t bytesWritten() const { return data_bytes_; }
+
+private:
+    std::ofstream out_;
+    std::string path_;
+    FrameEncoding encoding_;
+    int png_level_;
+    uint64_t position_;
+    uint64_t data_bytes_;
+    std::vector<FrameLogEntry> entries_;
+    std::vector<uint8_t> encoded_;
+};
+
+// 帧日志读取器：整个文件只读映射，RAW 帧零拷贝返回
+class FrameLogReader {
+public:
+    FrameLogReader();
+    ~FrameLogReader();
+
+    FrameLogReader(const FrameLogReader&) = delete;
+    FrameLogReader& operator=(const FrameLogReader&) = delete;
+
+    // 打开并校验日志文件
+    bool open(const std::string& path);
+
+    // 关闭并释放映射（之前返回的 RAW 帧随之失效）
+    void close();
+
+    // 帧数
+    size_t size() const { return entries_.size(); }
+
+    // 第 index 帧的索引信息
+    const FrameLogEntry& entry(size_t index) const { return entries_[index]; }
+
+    // 日志时长（最后一帧的时间戳，微秒）
+    uint64_t durationUs() const;
+
+    // 读取第 index 帧：RAW 帧返回指向映射内存的只读视图（在 close() 前有效），PNG 帧解码到 frame
+    bool read(size_t index, cv::Mat& frame) const;
+
+private:
+    int fd_;
+    uint8_t* mapping_;
+    size_t mapping_size_;
+    std::vector<FrameLogEntry> entries_;
+};
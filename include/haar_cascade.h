@@ -0,0 +1,88 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 扁平化的 Haar 级联分类器
+// 支持 stump 弱分类器、无倾斜特征的 BOOST 级联（如 haarcascade_frontalface_default.xml）
+// 模型按阶段顺序展开成数组结构体：每个 stump 的阈值、左右叶值、各矩形权重分别连续存放，
+// 特征矩形在设置图像时换算为积分图内的偏移，评估时不再查特征表
+// 检测语义与 cv::CascadeClassifier::detectMultiScale 一致（缩放序列、窗口步长、方差归一化、
+// 第0阶段拒绝后跳过下一窗口、候选框分组），输出相同的人脸框
+class HaarCascade {
+public:
+    HaarCascade();
+
+    // 从级联模型的根节点（FileStorage 的 cascade 节点）构建，模型不受支持时返回 false
+    bool read(const cv::FileNode& node);
+
+    bool empty() const { return stages_.empty(); }
+    cv::Size windowSize() const { return window_; }
+    size_t stageCount() const { return stages_.size(); }
+    size_t stumpCount() const { return threshold_.size(); }
+
+    // 是否使用 AVX2 内核（每次评估一行上相邻的8个窗口）；CPU 不支持时始终为标量内核
+    void setUseSimd(bool use_simd);
+    bool usesSimd() const { return use_simd_; }
+    static bool simdSupported();
+
+    // 多尺度检测，参数含义与 cv::CascadeClassifier::detectMultiScale 相同
+    // gray 为 CV_8UC1；各尺度与各行条带由 cv::parallel_for_ 并行（受 cv::setNumThreads 控制）
+    void detectMultiScale(const cv::Mat& gray, std::vector<cv::Rect>& objects,
+                          double scale_factor = 1.1, int min_neighbors = 3,
+                          cv::Size min_size = cv::Size(), cv::Size max_size = cv::Size()) const;
+
+    // 未分组的候选窗口（等价于 min_neighbors = 0）
+    void detectCandidates(const cv::Mat& gray, std::vector<cv::Rect>& candidates,
+                          double scale_factor = 1.1,
+                          cv::Size min_size = cv::Size(), cv::Size max_size = cv::Size()) const;
+
+private:
+    struct Stage {
+        int first;        // 第一个 stump 的下标
+        int count;        // stump 数
+        float threshold;  // 阶段阈值（已减去 OpenCV 使用的 1e-5 容差）
+    };
+
+    // 单个尺度在积分图缓冲区中的位置
+    struct ScaleLayer {
+        float scale;
+        int ystep;        // 窗口步长：scale < 2 时为 2，否则为 1
+        cv::Size size;    // 缩小后的图像尺寸（积分图为 size + 1）
+        int offset;       // 积分图左上角在缓冲区中的偏移（元素数）
+    };
+
+    // 每个线程复用的积分图缓冲区与偏移表
+    struct Workspace;
+    static Workspace& workspace();
+
+    // 计算缩放序列与各尺度在缓冲区中的布局（与 OpenCV 的 FeatureEvaluator 相同）
+    std::vector<ScaleLayer> layoutScales(const cv::Size& image_size, double scale_factor,
+                                         cv::Size min_size, cv::Size max_size, cv::Size& buffer_size) const;
+
+    // 按积分图行跨度计算各 stump 矩形和归一化矩形的偏移
+    void computeOffsets(Workspace& ws, int step) const;
+
+    // 扫描一个尺度的 [row_begin, row_end) 行窗口，通过全部阶段的窗口写入 hits（缩小后图像坐标）
+    void scanRowsScalar(const Workspace& ws, const ScaleLayer& layer, int row_begin, int row_end,
+                        std::vector<cv::Point>& hits) const;
+    void scanRowsSimd(const Workspace& ws, const ScaleLayer& layer, int row_begin, int row_end,
+                      std::vector<cv::Point>& hits) const;
+
+    // 标量评估单个窗口：返回 1 表示通过，0 表示在第0阶段被拒绝，-1 表示窗口无效或在后续阶段被拒绝
+    int evaluateWindow(const Workspace& ws, const int* sum, const int* sqsum, int first_stage) const;
+
+    cv::Size window_;
+    cv::Rect norm_rect_;
+    bool use_simd_;
+
+    // 阶段表
+    std::vector<Stage> stages_;
+
+    // stump 表（按阶段顺序展开，下标为 stump 序号）
+    std::vector<float> threshold_;
+    std::vector<float> left_;           // 特征值 < 阈值时的叶值
+    std::vector<float> right_;
+    std::vector<float> weight_[3];      // 各矩形权重，第三个矩形不存在时为 0
+    std::vector<cv::Rect> rect_[3];     // 各矩形在 24x24 窗口内的位置
+};
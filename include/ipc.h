@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 本地进程间通信工具（Unix 域套接字 + 长度前缀消息）
+namespace ipc {
+
+// 在指定路径上创建监听套接字，失败返回 -1
+int listenUnix(const std::string& path, int backlog = 16);
+
+// 连接到指定路径的套接字，失败返回 -1
+int connectUnix(const std::string& path);
+
+// 关闭套接字
+void closeSocket(int fd);
+
+// 完整写入 size 字节
+bool writeAll(int fd, const void* data, size_t size);
+
+// 完整读取 size 字节，timeout_ms < 0 表示无限等待
+bool readAll(int fd, void* data, size_t size, int timeout_ms = -1);
+
+// 发送一条消息：[uint32 长度][内容]
+bool sendMessage(int fd, const std::vector<uint8_t>& payload);
+
+// 接收一条消息，超时、断开或超出 max_size 时返回 false
+bool recvMessage(int fd, std::vector<uint8_t>& payload, int timeout_ms = -1,
+                 size_t max_size = 64 * 1024 * 1024);
+
+// 消息编码工具
+class Writer {
+public:
+    void putU8(uint8_t value);
+    void putU32(uint32_t value);
+    void putF32(float value);
+    void putF64(double value);
+    void putI32(int32_t value);
+    void putBytes(const void* data, size_t size);
+    void putString(const std::string& value);
+
+    std::vector<uint8_t>& buffer() { return buffer_; }
+
+private:
+    std::vector<uint8_t> buffer_;
+};
+
+// 消息解码工具，越界时 ok() 返回 false
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size);
+    explicit Reader(const std::vector<uint8_t>& payload);
+
+    uint8_t getU8();
+    uint32_t getU32();
+    float getF32();
+    double getF64();
+    int32_t getI32();
+    bool getBytes(void* out, size_t size);
+    const uint8_t* skipBytes(size_t size);
+    std::string getString();
+
+    bool ok() const { return ok_; }
+    size_t remaining() const { return size_ - pos_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+    bool ok_;
+};
+
+} // namespace ipc
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// 未匹配（Unknown）的标签ID（保留，intern 不会返回此ID）
+const uint32_t kUnknownLabel = 0;
+
+// 标签驻留表：每个标签名只保存一份，识别结果中只携带整数ID
+// 名称存放在 deque 中，返回的引用在进程生命周期内始终有效
+class LabelTable {
+public:
+    LabelTable();
+
+    // 进程内共享的标签表（FaceManager 注册身份时写入，识别引擎和显示按ID读取）
+    static LabelTable& global();
+
+    // 返回标签ID，不存在时添加（名称为 "Unknown" 的标签同样分配新ID，不与 kUnknownLabel 混淆）
+    uint32_t intern(const std::string& name);
+
+    // 查找标签ID（不分配内存），不存在时返回 kUnknownLabel
+    uint32_t find(const std::string& name) const;
+
+    // 按ID取名称，ID无效时返回 "Unknown"
+    const std::string& name(uint32_t id) const;
+
+    // 标签数量（包含 Unknown）
+    size_t size() const;
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::deque<std::string> names_;
+    std::unordered_map<std::string, uint32_t> ids_;
+};
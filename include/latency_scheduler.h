@@ -0,0 +1,87 @@
+#pragma once
+
+#include "face_detection.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 检测质量等级：检测参数 + 检测频率
+struct QualityLevel {
+    DetectionParams params;
+    int detect_interval;   // 每 N 帧运行一次检测，其余帧复用上次检测结果
+};
+
+// 调度器统计信息
+struct SchedulerStats {
+    int level = 0;                  // 当前质量等级（0 为最高质量）
+    int level_count = 0;            // 质量等级总数
+    double budget_ms = 0.0;         // 每帧延迟预算
+    double achieved_fps = 0.0;      // 实际帧率（按帧间隔的指数平均）
+    double avg_frame_ms = 0.0;      // 每帧处理耗时（指数平均）
+    double avg_detect_ms = 0.0;     // 检测耗时（指数平均）
+    uint64_t frames = 0;
+    uint64_t detections = 0;
+    uint64_t detections_skipped = 0;
+    uint64_t level_changes = 0;
+};
+
+// 延迟预算调度器：根据实测耗时在质量等级之间切换，使每帧耗时保持在预算内
+// 滞回规则：连续若干帧超出预算才降级，连续更多帧明显低于预算才升级，避免来回振荡
+class LatencyScheduler {
+public:
+    LatencyScheduler();
+
+    // 设置每帧延迟预算（毫秒），0 表示关闭调度
+    void setBudgetMs(double budget_ms);
+
+    // 检查调度是否启用
+    bool enabled() const;
+
+    // 开始新的一帧：统计帧数和实际帧率，每帧调用一次（包括被运动门控跳过检测的帧）
+    void beginFrame();
+
+    // 判断本帧是否检测：需要检测时返回 true 并输出本帧检测参数，
+    // 否则返回 false 并输出上次检测到的人脸
+    bool shouldDetect(DetectionParams& params, std::vector<cv::Rect>& reused_faces);
+
+    // 记录本帧检测耗时和结果（只在实际运行检测时调用）
+    void recordDetection(double detect_ms, const std::vector<cv::Rect>& faces);
+
+    // 记录本帧总耗时，并按滞回规则调整质量等级
+    void endFrame(double frame_ms);
+
+    // 获取统计信息
+    SchedulerStats getStats() const;
+
+private:
+    // 切换质量等级
+    void changeLevel(int level);
+
+private:
+    std::vector<QualityLevel> levels_;
+    double budget_ms_;
+    int level_;
+
+    // 滞回参数
+    double upgrade_ratio_;     // 耗时低于预算的该比例才考虑升级
+    int degrade_after_;        // 连续超预算帧数
+    int upgrade_after_;        // 连续低于升级阈值帧数
+    int over_count_;
+    int under_count_;
+    int frames_at_level_;
+
+    // 各等级最近一次实测的平均帧耗时，升级前据此预判，过期后重新试探
+    std::vector<double> level_cost_;
+    std::vector<uint64_t> level_cost_frame_;
+    uint64_t cost_expiry_frames_;
+
+    int frames_since_detect_;
+    std::vector<cv::Rect> last_faces_;
+
+    bool has_last_frame_;
+    std::chrono::steady_clock::time_point last_frame_time_;
+
+    mutable std::mutex mutex_;
+    SchedulerStats stats_;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 运动门控配置
+struct MotionGateOptions {
+    bool enabled = false;
+    int downsample_width = 160;       // 背景模型的降采样宽度
+    double background_alpha = 0.05;   // 背景更新率（accumulateWeighted）
+    int pixel_threshold = 25;         // 像素与背景差值超过该值视为变化
+    double motion_ratio = 0.005;      // 变化像素比例超过该值视为有运动
+    int force_interval = 30;          // 每 N 帧强制检测一次，0 表示不强制
+};
+
+// 运动门控统计
+struct MotionGateStats {
+    uint64_t frames = 0;
+    uint64_t detections = 0;
+    uint64_t skipped = 0;             // 因画面静止跳过的检测
+    uint64_t forced = 0;              // 画面静止但按间隔强制的检测
+    double skip_ratio = 0.0;
+    double avg_gate_ms = 0.0;         // 门控自身耗时（指数平均）
+    double avg_detect_ms = 0.0;       // 检测耗时（指数平均）
+    double saved_ms = 0.0;            // 估算节省的CPU时间：跳过次数 × 检测耗时 − 门控总耗时
+    double last_motion_ratio = 0.0;
+};
+
+// 运动门控：在降采样灰度图上维护滑动平均背景，画面与背景差异很小时跳过人脸检测并复用上次结果
+class MotionGate {
+public:
+    MotionGate();
+
+    // 设置配置并重置背景模型
+    void configure(const MotionGateOptions& options);
+
+    // 检查门控是否启用
+    bool enabled() const;
+
+    // 判断本帧是否需要检测；不需要时返回 false 并输出上次检测到的人脸
+    bool shouldDetect(const cv::Mat& frame, std::vector<cv::Rect>& reused_faces);
+
+    // 记录本帧检测耗时和结果（只在级联实际运行时调用，复用结果的帧不记录）
+    void recordDetection(double detect_ms, const std::vector<cv::Rect>& faces);
+
+    // 获取统计信息
+    MotionGateStats getStats() const;
+
+private:
+    MotionGateOptions options_;
+    cv::Mat background_;               // CV_32F 背景模型
+    cv::Mat gray_;
+    cv::Mat diff_;
+    int frames_since_detect_;
+    bool has_detection_;
+    std::vector<cv::Rect> last_faces_;
+
+    mutable std::mutex mutex_;
+    MotionGateStats stats_;
+    double total_gate_ms_;
+};
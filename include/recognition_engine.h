@@ -1,9 +1,80 @@
 #pragma once
 
+#include "label_table.h"
+#include "latency_scheduler.h"
+#include "motion_gate.h"
+#include "thread_pool.h"
 #include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+class TieredGallery;
+class ShardCoordinator;
+struct FaceIdentity;
+struct YuvFrame;
+
+// 单帧识别结果
+typedef std::vector<std::pair<cv::Rect, std::string>> FrameResults;
+
+// 单张人脸的识别结果：标签以 LabelTable::global() 中的ID表示，不携带字符串
+struct RecognitionResult {
+    cv::Rect rect;
+    uint32_t label_id = kUnknownLabel;  // 未通过阈值时为 kUnknownLabel
+    float similarity = -1.0f;           // 最佳匹配的余弦相似度
+    float confidence = 0.0f;            // 相似度超出接受阈值的程度，归一化到 [0, 1]；未接受时为 0
+};
+
+// 单帧识别结果缓冲区（由调用方持有，逐帧复用）
+typedef std::vector<RecognitionResult> RecognitionResults;
+
+// 异步处理回调：帧序号与识别结果（标签为ID）
+typedef std::function<void(uint64_t frame_id, const RecognitionResults& results)> FrameCallback;
+
+// 在途帧数达到上限时的处理策略
+enum class AsyncOverflowPolicy {
+    BLOCK,   // 阻塞调用者直到有空位（背压）
+    REJECT   // 立即拒绝该帧
+};
+
+// 异步处理配置
+struct AsyncOptions {
+    size_t worker_threads = 2;                           // 工作线程数
+    size_t max_in_flight = 4;                            // 最大在途帧数
+    AsyncOverflowPolicy overflow = AsyncOverflowPolicy::BLOCK;
+    bool ordered_delivery = false;                       // 回调是否按提交顺序触发
+};
+
+// 单个处理阶段的并行方式
+enum class ParallelPolicy {
+    SERIAL,         // 单线程（两个阶段都不是 INTRA_OPENCV 时 OpenCV 内部线程数为 1）
+    INTRA_OPENCV,   // 由 OpenCV 内部并行（cv::parallel_for_），线程数为并行线程预算
+    INTER_FACE      // 按人脸分发到引擎线程池
+};
+
+// 引擎并行配置：引擎线程池与 OpenCV 内部线程共用同一个线程预算，避免互相抢占CPU
+struct ParallelOptions {
+    size_t threads = 0;                                     // 线程预算，0 表示可用CPU数
+    AffinityMode affinity = AffinityMode::NONE;             // 引擎线程池的CPU绑定方式
+    ParallelPolicy detection = ParallelPolicy::INTRA_OPENCV;    // 检测阶段（单次调用，INTER_FACE 按 INTRA_OPENCV 处理）
+    ParallelPolicy extraction = ParallelPolicy::INTER_FACE;     // 特征提取阶段
+};
+
+// 异步处理统计
+struct AsyncStats {
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    uint64_t rejected = 0;
+    size_t in_flight = 0;
+    size_t peak_in_flight = 0;
+};
+
 class RecognitionEngine {
 public:
     RecognitionEngine();
@@ -18,26 +89,228 @@ public:
         const std::vector<cv::Mat>& known_features,
         const std::vector<std::string>& known_labels);
     
+    // 处理单帧图像（按身份匹配：先比对平均模板，再比对候选身份的全部样本）
+    std::vector<std::pair<cv::Rect, std::string>> processFrame(
+        const cv::Mat& frame,
+        const std::vector<FaceIdentity>& identities);
+    
+    // 处理单帧图像（使用分层图库匹配）
+    std::vector<std::pair<cv::Rect, std::string>> processFrame(
+        const cv::Mat& frame,
+        TieredGallery& gallery);
+    
+    // 处理单帧图像（分发到分片图库匹配）
+    std::vector<std::pair<cv::Rect, std::string>> processFrame(
+        const cv::Mat& frame,
+        ShardCoordinator& shards);
+    
+    // 处理单帧图像，结果写入调用方提供的 results（先清空，复用已有容量）
+    // 标签以整数ID返回，匹配与绘制过程中不再分配标签字符串
+    void processFrame(const cv::Mat& frame,
+                      const std::vector<cv::Mat>& known_features,
+                      const std::vector<uint32_t>& known_label_ids,
+                      RecognitionResults& results);
+    void processFrame(const cv::Mat& frame,
+                      const std::vector<FaceIdentity>& identities,
+                      RecognitionResults& results);
+    void processFrame(const cv::Mat& frame,
+                      TieredGallery& gallery,
+                      RecognitionResults& results);
+    void processFrame(const cv::Mat& frame,
+                      ShardCoordinator& shards,
+                      RecognitionResults& results);
+    
+    // 处理 NV12/I420 帧：在亮度平面上检测（整帧不做颜色转换），只把人脸区域转换为BGR后提取特征
+    void processFrame(const YuvFrame& frame,
+                      const std::vector<cv::Mat>& known_features,
+                      const std::vector<uint32_t>& known_label_ids,
+                      RecognitionResults& results);
+    void processFrame(const YuvFrame& frame,
+                      const std::vector<FaceIdentity>& identities,
+                      RecognitionResults& results);
+    void processFrame(const YuvFrame& frame,
+                      TieredGallery& gallery,
+                      RecognitionResults& results);
+    void processFrame(const YuvFrame& frame,
+                      ShardCoordinator& shards,
+                      RecognitionResults& results);
+    
+    // 身份匹配：第一轮比对平均模板，取前 candidate_count 个身份再比对其全部样本
+    std::string matchIdentity(const cv::Mat& features,
+                              const std::vector<FaceIdentity>& identities,
+                              size_t candidate_count = 3,
+                              double* similarity = nullptr);
+    
+    // 身份匹配（按标签ID），结果写入 result 的 label_id / similarity / confidence
+    void matchIdentity(const cv::Mat& features,
+                       const std::vector<FaceIdentity>& identities,
+                       RecognitionResult& result,
+                       size_t candidate_count = 3);
+    
+    // 设置每帧延迟预算（毫秒），调度器据此调整检测质量；0 表示关闭
+    void setLatencyBudget(double budget_ms);
+    
+    // 获取调度器统计（实际帧率、当前质量等级等）
+    SchedulerStats getSchedulerStats() const;
+    
+    // 配置运动门控：画面静止时跳过人脸检测并复用上次结果
+    void setMotionGate(const MotionGateOptions& options);
+    
+    // 获取运动门控统计（跳过比例、节省的检测耗时等）
+    MotionGateStats getMotionGateStats() const;
+    
+    // 配置并行方式：创建引擎线程池（异步处理与按人脸并行共用），并设置一次 OpenCV 内部线程数
+    // 应在开始处理前调用，会等待在途帧完成
+    void configureParallel(const ParallelOptions& options);
+    
+    // 配置异步处理（未配置并行方式时按 worker_threads 重新创建工作线程池，会等待在途帧完成）
+    void configureAsync(const AsyncOptions& options);
+    
+    // 异步处理单帧图像，返回结果的 future；被拒绝时返回无效的 future
+    // 按身份匹配（与同步的 processFrame(frame, identities, ...) 一致）
+    // 帧会被复制，identities 在处理完成前必须保持有效且不被修改
+    // 异步帧不经过运动门控和延迟预算调度器：两者的状态（背景模型、复用的检测结果、跳帧计数）依赖帧的采集顺序，
+    // 而多个工作线程上的帧会乱序到达，经过它们可能把一帧的检测结果用在另一帧上
+    std::future<RecognitionResults> processFrameAsync(
+        const cv::Mat& frame,
+        const std::vector<FaceIdentity>& identities);
+    
+    // 异步处理单帧图像，完成后在工作线程上调用回调；被拒绝时返回 false
+    bool processFrameAsync(
+        const cv::Mat& frame,
+        const std::vector<FaceIdentity>& identities,
+        FrameCallback callback);
+    
+    // 等待所有在途帧完成
+    void waitAsyncIdle();
+    
+    // 获取异步处理统计
+    AsyncStats getAsyncStats() const;
+    
+    // 人脸匹配（similarity 非空时输出最佳相似度）
+    std::string matchFace(const cv::Mat& features,
+                          const std::vector<cv::Mat>& known_features,
+                          const std::vector<std::string>& known_labels,
+                          double* similarity = nullptr);
+    
+    // 人脸匹配（按标签ID），结果写入 result 的 label_id / similarity / confidence
+    void matchFace(const cv::Mat& features,
+                   const std::vector<cv::Mat>& known_features,
+                   const std::vector<uint32_t>& known_label_ids,
+                   RecognitionResult& result);
+    
+    // 对一批已裁剪的人脸提取特征，按输入顺序返回（空图像或提取失败的位置为空）
+    // 特征提取阶段为 INTER_FACE 时分发到引擎线程池
+    std::vector<cv::Mat> extractFeatureBatch(const std::vector<cv::Mat>& crops);
+    
+    // 按各匹配方式为已提取特征的人脸填写结果（faces 与 features 一一对应，特征不能为空）
+    // 标签以ID返回，不输出逐张人脸的日志
+    void matchFaces(const std::vector<cv::Rect>& faces, const std::vector<cv::Mat>& features,
+                    const std::vector<cv::Mat>& known_features, const std::vector<uint32_t>& known_label_ids,
+                    RecognitionResults& results);
+    void matchFaces(const std::vector<cv::Rect>& faces, const std::vector<cv::Mat>& features,
+                    const std::vector<FaceIdentity>& identities, RecognitionResults& results);
+    void matchFaces(const std::vector<cv::Rect>& faces, const std::vector<cv::Mat>& features,
+                    TieredGallery& gallery, RecognitionResults& results);
+    void matchFaces(const std::vector<cv::Rect>& faces, const std::vector<cv::Mat>& features,
+                    ShardCoordinator& shards, RecognitionResults& results);
+    
     // 绘制识别结果
     void drawResults(cv::Mat& frame, 
                     const std::vector<std::pair<cv::Rect, std::string>>& results);
+    void drawResults(cv::Mat& frame, const RecognitionResults& results);
 
 private:
-    // 人脸检测
+    // 人脸检测：先经过运动门控，再按延迟预算调度器的参数检测
     std::vector<cv::Rect> detectFaces(const cv::Mat& frame);
     
+    // 异步帧的处理：直接检测，不经过运动门控和调度器，也不计入调度器的帧耗时
+    void processAsyncFrame(const cv::Mat& frame, const std::vector<FaceIdentity>& identities,
+                           RecognitionResults& results);
+    
+    // 按并行配置设置 OpenCV 内部线程数（只在 configureParallel/configureAsync 中调用）
+    void applyOpenCVThreads();
+    
     // 特征提取
     std::vector<cv::Mat> extractFeatures(const cv::Mat& frame, 
                                         const std::vector<cv::Rect>& faces);
     
-    // 人脸匹配
-    std::string matchFace(const cv::Mat& features,
+    // 对已裁剪的人脸图像提取特征（空图像视为提取失败）
+    std::vector<cv::Mat> extractFeatures(const std::vector<cv::Mat>& crops);
+    
+    // 人脸检测 + 特征提取，没有人脸或提取失败时返回 false
+    bool detectAndExtract(const cv::Mat& frame, std::vector<cv::Rect>& faces, std::vector<cv::Mat>& features);
+    bool detectAndExtract(const YuvFrame& frame, std::vector<cv::Rect>& faces, std::vector<cv::Mat>& features);
+    
+    // 在全部样本中查找最佳匹配，返回下标
+    size_t findBestSample(const cv::Mat& features,
                           const std::vector<cv::Mat>& known_features,
-                          const std::vector<std::string>& known_labels);
+                          double& best_similarity);
+    
+    // 两轮身份匹配，返回最佳身份的下标
+    size_t findBestIdentity(const cv::Mat& features,
+                            const std::vector<FaceIdentity>& identities,
+                            size_t candidate_count,
+                            double& best_similarity);
+    
+    // 多阈值动态匹配策略：返回是否接受，threshold 输出最终使用的阈值（不输出日志）
+    static bool passesMatchThreshold(double best_similarity, double& threshold);
+    
+    // 输出匹配判定日志（仅返回标签字符串的旧接口使用）
+    static void logMatchDecision(const std::string& best_match, double best_similarity, double threshold);
+    
+    // 按匹配策略填写结果的标签ID、相似度和置信度
+    void resolveMatch(uint32_t best_label_id, double best_similarity, RecognitionResult& result);
+    
+    // 将ID结果转换为带标签名的结果（兼容返回 FrameResults 的接口）
+    static FrameResults toFrameResults(const RecognitionResults& results);
+    
+    // 标签文字尺寸（按标签ID缓存，每个标签只测量一次）
+    cv::Size labelExtent(uint32_t label_id);
     
     // 绘制标签
-    void drawLabel(cv::Mat& frame, const cv::Rect& rect, const std::string& text);
+    void drawLabel(cv::Mat& frame, const cv::Rect& rect, const std::string& text, const cv::Size& text_size);
+    
+    // 占用一个在途名额，按溢出策略阻塞或拒绝；返回帧序号
+    bool acquireSlot(uint64_t& frame_id);
+    
+    // 释放在途名额
+    void releaseSlot();
+    
+    // 触发回调（有序模式下缓存乱序完成的结果）
+    void deliver(uint64_t frame_id, RecognitionResults results, const FrameCallback& callback);
+    
+    // 调用回调并吞掉其抛出的异常（记录日志）
+    static void invokeCallback(const FrameCallback& callback, uint64_t frame_id, const RecognitionResults& results);
 
 private:
     bool initialized_;
+    
+    // 延迟预算调度器
+    LatencyScheduler scheduler_;
+    
+    // 运动门控
+    MotionGate motion_gate_;
+    
+    // 并行配置
+    ParallelOptions parallel_options_;
+    bool parallel_configured_;
+    bool async_configured_;
+    
+    // 异步处理状态（线程池同时用于按人脸并行）
+    AsyncOptions async_options_;
+    std::unique_ptr<ThreadPool> pool_;
+    mutable std::mutex async_mutex_;
+    std::condition_variable async_cv_;
+    uint64_t next_frame_id_;
+    AsyncStats async_stats_;
+    
+    // 有序交付：等待前序帧完成的结果
+    std::mutex delivery_mutex_;
+    uint64_t next_delivery_id_;
+    std::map<uint64_t, std::pair<RecognitionResults, FrameCallback>> pending_delivery_;
+    
+    // 标签文字尺寸缓存（下标为标签ID，宽度为 0 表示尚未测量）
+    std::mutex label_extent_mutex_;
+    std::vector<cv::Size> label_extents_;
 };
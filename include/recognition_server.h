@@ -0,0 +1,153 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class RecognitionEngine;
+class TieredGallery;
+class ShardCoordinator;
+struct FaceIdentity;
+struct RecognitionResult;
+
+// 服务端协议（长度前缀二进制消息，见 ipc.h）
+// 请求：[uint8 类型][内容]
+//   REQUEST_IMAGE  内容为编码后的整幅图像（jpg/png等），服务端先检测人脸
+//   REQUEST_FACE   内容为编码后的已裁剪人脸，整幅图像作为一个人脸
+//   REQUEST_STATS  无内容，返回服务端统计信息
+// 识别响应：[uint8 状态][uint32 人脸数] 人脸数 × ([int32 x][int32 y][int32 w][int32 h][double 相似度][string 标签])
+// 统计响应：[uint8 状态][uint32 最大批大小][uint32 最大等待毫秒]
+//           [double 请求数][double 批次数][double 平均批大小][double 吞吐量][double p50毫秒][double p99毫秒]
+enum ServerRequestType : uint8_t {
+    REQUEST_IMAGE = 1,
+    REQUEST_FACE = 2,
+    REQUEST_STATS = 3
+};
+
+enum ServerStatus : uint8_t {
+    STATUS_OK = 0,
+    STATUS_BAD_REQUEST = 1,
+    STATUS_UNAVAILABLE = 2
+};
+
+// 服务端配置
+struct ServerConfig {
+    std::string socket_path = "/tmp/face_recognition.sock";
+    size_t max_batch_size = 8;   // 每批最多合并的请求数
+    int max_wait_ms = 5;         // 批次中第一个请求的最长等待时间
+};
+
+// 服务端统计信息
+struct ServerStats {
+    uint64_t requests = 0;
+    uint64_t batches = 0;
+    uint64_t faces = 0;
+    double mean_batch_size = 0.0;
+    double throughput = 0.0;     // 请求/秒
+    double p50_latency_ms = 0.0;
+    double p99_latency_ms = 0.0;
+};
+
+// 识别服务：通过本地套接字接收图像或人脸，合并为批次后统一提取特征和匹配
+class RecognitionServer {
+public:
+    // 按身份匹配（与主程序同步处理的匹配方式一致），identities 在服务运行期间必须保持有效且不被修改
+    RecognitionServer(RecognitionEngine& engine, const std::vector<FaceIdentity>& identities);
+    
+    // 在分层图库中匹配，gallery 在服务运行期间必须保持打开
+    RecognitionServer(RecognitionEngine& engine, TieredGallery& gallery);
+    
+    // 分发到分片图库匹配，shards 在服务运行期间必须保持运行
+    RecognitionServer(RecognitionEngine& engine, ShardCoordinator& shards);
+    ~RecognitionServer();
+
+    RecognitionServer(const RecognitionServer&) = delete;
+    RecognitionServer& operator=(const RecognitionServer&) = delete;
+
+    // 启动监听与批处理线程
+    bool start(const ServerConfig& config);
+
+    // 停止服务并等待所有线程退出
+    void stop();
+
+    // 检查是否正在运行
+    bool isRunning() const;
+
+    // 获取统计信息
+    ServerStats getStats() const;
+
+    // 打印统计信息
+    void printStats() const;
+
+private:
+    struct FaceResult {
+        cv::Rect rect;
+        uint32_t label_id;   // LabelTable::global() 中的ID，回复时再写入标签名
+        double similarity;
+    };
+
+    struct PendingRequest {
+        ServerRequestType type;
+        cv::Mat image;
+        std::chrono::steady_clock::time_point arrival;
+        std::promise<std::vector<FaceResult>> result;
+        bool answered = false;   // result 已设置
+    };
+
+    // 接受新连接
+    void acceptLoop();
+
+    // 处理单个连接上的请求
+    void connectionLoop(int fd);
+
+    // 合并请求为批次并处理
+    void batchLoop();
+
+    // 处理一个批次（异常向外抛出，由 batchLoop 转交给尚未应答的请求）
+    void processBatch(std::vector<PendingRequest>& batch);
+
+    // 按构造时指定的图库来源匹配已提取特征的人脸
+    void matchFaces(const std::vector<cv::Rect>& faces, const std::vector<cv::Mat>& features,
+                    std::vector<RecognitionResult>& results);
+
+    // 记录请求延迟
+    void recordLatency(double latency_ms);
+
+private:
+    RecognitionEngine& engine_;
+
+    // 图库来源（三者只有一个非空）
+    const std::vector<FaceIdentity>* identities_;
+    TieredGallery* gallery_;
+    ShardCoordinator* shards_;
+
+    ServerConfig config_;
+    int listen_fd_;
+    std::atomic<bool> running_;
+
+    std::thread accept_thread_;
+    std::thread batch_thread_;
+
+    std::mutex connections_mutex_;
+    std::condition_variable connections_cv_;
+    std::vector<int> connection_fds_;
+    size_t active_connections_;
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<PendingRequest> queue_;
+
+    mutable std::mutex stats_mutex_;
+    ServerStats stats_;
+    std::vector<double> latencies_;   // 最近的请求延迟（环形缓冲）
+    size_t latency_pos_;
+    std::chrono::steady_clock::time_point start_time_;
+};
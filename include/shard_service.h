@@ -0,0 +1,87 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+// 分片匹配结果
+struct ShardMatch {
+    uint32_t label_id;    // LabelTable::global() 中的标签ID
+    double similarity;
+    int shard;
+};
+
+// 分片协调器统计信息
+struct ShardStats {
+    uint64_t queries = 0;        // 查询次数
+    uint64_t partial = 0;        // 部分分片未返回的查询
+    uint64_t timeouts = 0;       // 分片超时次数
+    uint64_t failures = 0;       // 分片通信失败次数
+    uint64_t reconnects = 0;     // 重新连接次数
+};
+
+// 分片图库协调器：图库按轮询方式划分到多个工作进程，
+// 每次查询分发到所有分片（scatter），再合并各分片的 top-k 结果（gather）
+class ShardCoordinator {
+public:
+    ShardCoordinator();
+    ~ShardCoordinator();
+
+    ShardCoordinator(const ShardCoordinator&) = delete;
+    ShardCoordinator& operator=(const ShardCoordinator&) = delete;
+
+    // 划分图库并启动 shard_count 个工作进程；标签在此时驻留到 LabelTable::global()，
+    // 分片之间只传递标签ID，查询时不再分配标签字符串
+    bool start(const std::vector<cv::Mat>& features,
+               const std::vector<std::string>& labels,
+               int shard_count);
+
+    // 停止所有工作进程
+    void stop();
+
+    // 检查是否正在运行
+    bool isRunning() const;
+
+    // 获取分片数量
+    int shardCount() const;
+
+    // 设置单次查询的超时时间（毫秒）
+    void setTimeoutMs(int timeout_ms);
+
+    // 查询最相似的 top_k 个身份（按相似度降序），至少一个分片返回时成功
+    // 可由多个线程并发调用：每次查询只在取出、归还各分片的连接时加锁，收发期间各用自己的连接
+    bool query(const cv::Mat& features, size_t top_k, std::vector<ShardMatch>& matches);
+
+    // 获取统计信息
+    ShardStats getStats() const;
+
+    // 打印统计信息
+    void printStats() const;
+
+private:
+    struct Shard {
+        pid_t pid;
+        std::string socket_path;
+        std::vector<int> idle_fds;   // 空闲连接，查询时取出，正常收发后归还
+        bool lost;                   // 有连接因超时或失败被断开，下次新建连接计为重连
+        size_t size;
+    };
+
+    // 取出一条空闲连接，没有时新建连接；调用时需持有 mutex_
+    int checkoutConnection(Shard& shard);
+
+    // 关闭分片的所有空闲连接；调用时需持有 mutex_
+    void closeIdleConnections(Shard& shard);
+
+private:
+    std::vector<Shard> shards_;
+    uint64_t generation_;   // 每次 stop() 加一，查询归还连接时据此判断分片是否已重建
+    int timeout_ms_;
+    int dimension_;
+
+    mutable std::mutex mutex_;
+    ShardStats stats_;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// 工作线程的CPU亲和性
+enum class AffinityMode {
+    NONE,   // 不绑定，由系统调度
+    CORE,   // 每个工作线程绑定一个CPU核心（轮流分配）
+    NUMA    // 每个工作线程绑定到一个NUMA节点的全部核心（轮流分配）
+};
+
+// 线程池配置
+struct ThreadPoolOptions {
+    size_t num_threads = 0;                  // 0 表示使用可用CPU数
+    AffinityMode affinity = AffinityMode::NONE;
+};
+
+// 固定大小的工作线程池
+class ThreadPool {
+public:
+    // num_threads 为 0 时使用硬件线程数
+    explicit ThreadPool(size_t num_threads = 0);
+    explicit ThreadPool(const ThreadPoolOptions& options);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 提交任务，返回结果的 future
+    template <typename F>
+    auto submit(F&& task) -> std::future<typename std::invoke_result<F>::type> {
+        typedef typename std::invoke_result<F>::type Result;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    // 提交不需要返回值的任务
+    void enqueue(std::function<void()> task);
+
+    // 等待队列中的任务全部完成
+    void waitIdle();
+
+    // 停止线程池（等待已提交的任务完成）
+    void shutdown();
+
+    // 并行执行 body(0) … body(count - 1)，调用线程也参与执行，全部完成后返回
+    // 在本线程池的工作线程中调用时（嵌套并行）直接串行执行，避免占满线程池后互相等待
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // 当前线程是否为本线程池的工作线程
+    bool isWorkerThread() const;
+
+    // 获取工作线程数
+    size_t size() const;
+
+    // 当前进程可用的CPU列表（sched_getaffinity）
+    static std::vector<int> availableCpus();
+
+    // 按NUMA节点分组的可用CPU（读取 /sys/devices/system/node），无NUMA信息时返回单个节点
+    static std::vector<std::vector<int>> numaNodes();
+
+private:
+    void start(size_t num_threads);
+    void workerLoop(size_t index);
+    void pinWorker(size_t index);
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable task_cv_;
+    std::condition_variable idle_cv_;
+    size_t busy_;
+    bool stopping_;
+    AffinityMode affinity_;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 分层图库统计信息
+struct TieredGalleryStats {
+    uint64_t lookups = 0;             // 匹配查询次数
+    uint64_t hot_hits = 0;            // 热层直接命中（无需扫描冷层）的查询
+    uint64_t cold_hits = 0;           // 需要扫描冷层的查询
+    uint64_t page_ins = 0;            // 从冷层换入热层的身份数
+    uint64_t evictions = 0;           // 热层淘汰次数
+    uint64_t cold_bytes_scanned = 0;  // 冷层累计扫描字节数
+
+    size_t hot_count = 0;             // 当前热层身份数
+    size_t hot_capacity = 0;          // 热层容量（身份数）
+    size_t cold_count = 0;            // 冷层身份总数
+    size_t memory_budget = 0;         // 内存预算（字节）
+
+    // 热层命中率
+    double hotHitRate() const;
+
+    // 冷层命中率
+    double coldHitRate() const;
+};
+
+// 分层图库：热层为内存中的LRU缓存，冷层为按需换入的内存映射文件
+class TieredGallery {
+public:
+    TieredGallery();
+    ~TieredGallery();
+
+    TieredGallery(const TieredGallery&) = delete;
+    TieredGallery& operator=(const TieredGallery&) = delete;
+
+    // 将特征和标签写入冷层文件
+    static bool writeColdStore(const std::string& path,
+                               const std::vector<cv::Mat>& features,
+                               const std::vector<std::string>& labels);
+
+    // 打开冷层文件，memory_budget_bytes 为热层与扫描窗口共用的内存预算
+    bool open(const std::string& path, size_t memory_budget_bytes);
+
+    // 关闭图库并释放映射
+    void close();
+
+    // 检查图库是否已打开
+    bool isOpen() const;
+
+    // 获取身份数量
+    size_t size() const;
+
+    // 获取特征维度
+    int dimension() const;
+
+    // 设置热层直接接受的相似度（达到后不再扫描冷层）
+    // 默认关闭（阈值大于1）；设置为不大于1的值后 findBestMatch 变为近似匹配：
+    // 热层命中达到阈值即返回，冷层中可能存在相似度更高的身份
+    void setHotAcceptSimilarity(double similarity);
+
+    // 获取第 index 个身份的特征（归一化后），按需换入热层
+    cv::Mat getFeature(size_t index);
+
+    // 获取第 index 个身份的标签
+    std::string getLabel(size_t index) const;
+
+    // 按顺序读取全部特征（行优先、已归一化）和标签，不经过热层，扫描过的页面会被释放
+    bool readAll(std::vector<float>& features, std::vector<std::string>& labels);
+
+    // 查找最佳匹配：先查热层，未达到接受阈值时扫描冷层（默认总是扫描，结果为全图库的精确最佳匹配）
+    // 标签以 LabelTable::global() 中的ID返回，身份换入热层时驻留一次
+    bool findBestMatch(const cv::Mat& query,
+                       size_t& best_index,
+                       uint32_t& best_label_id,
+                       double& best_similarity);
+
+    // 获取统计信息
+    TieredGalleryStats getStats() const;
+
+    // 打印统计信息
+    void printStats() const;
+
+private:
+    struct HotEntry {
+        std::vector<float> feature;
+        uint32_t label_id;
+        std::list<size_t>::iterator lru_pos;
+    };
+
+    // 冷层中第 index 个特征的起始地址
+    const float* coldFeature(size_t index) const;
+
+    // 从映射中读取标签（不加锁）
+    std::string readLabel(size_t index) const;
+
+    // 将身份换入热层（已在热层时只更新LRU位置）
+    HotEntry& touch(size_t index);
+
+    // 扫描冷层，按窗口释放已扫描的页面以控制常驻内存
+    void scanCold(const std::vector<float>& query, size_t& best_index, double& best_similarity);
+
+private:
+    int fd_;
+    uint8_t* mapping_;
+    size_t mapping_size_;
+
+    uint32_t dimension_;
+    uint64_t count_;
+    uint64_t features_offset_;
+    uint64_t labels_offset_;
+
+    size_t memory_budget_;
+    size_t hot_capacity_;
+    size_t scan_window_bytes_;
+    double hot_accept_similarity_;
+    std::vector<float> query_buffer_;   // 归一化的查询向量（受 mutex_ 保护）
+
+    std::list<size_t> lru_;
+    std::unordered_map<size_t, HotEntry> hot_;
+
+    mutable std::mutex mutex_;
+    TieredGalleryStats stats_;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// 流水线耗时追踪：记录各阶段的起止时间，导出为 Chrome trace-event JSON（可在 Perfetto / chrome://tracing 中打开）
+// 事件写入各线程自己的缓冲区，只有导出时才加锁合并；关闭时每个 TRACE_SPAN 只有一次原子读取
+namespace trace {
+
+extern std::atomic<bool> g_enabled;
+
+// 检查追踪是否开启
+inline bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+// 清空已有事件并开始追踪
+void start();
+
+// 停止追踪（已记录的事件保留，可继续导出）
+void stop();
+
+// 设置当前线程在追踪视图中的名称
+void setThreadName(const std::string& name);
+
+// 导出已记录的事件为 Chrome trace-event JSON
+bool dumpJson(const std::string& path);
+
+// 已记录的事件数
+size_t eventCount();
+
+// 作用域耗时：构造时记录开始时间，析构时写入当前线程的缓冲区
+// name 必须是字符串常量（只保存指针）
+class Span {
+public:
+    explicit Span(const char* name) : name_(name), start_us_(enabled() ? nowUs() : -1) {}
+    ~Span() {
+        if (start_us_ >= 0) {
+            record(name_, start_us_, nowUs() - start_us_);
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    static int64_t nowUs();
+    static void record(const char* name, int64_t start_us, int64_t duration_us);
+
+    const char* name_;
+    int64_t start_us_;
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+// 在当前作用域内记录一个名为 name 的耗时区间
+#define TRACE_SPAN(name) ::trace::Span TRACE_CONCAT(trace_span_, __LINE__)(name)
@@ -5,7 +5,7 @@
 
 namespace utils {
 
-// 获取项目根目录
+// 获取项目根目录（首次调用时探测并缓存，以下路径函数同理）
 std::string getProjectRoot();
 
 // 获取模型文件路径
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+// 4:2:0 平面YUV格式
+enum class YuvLayout {
+    NV12,   // Y 平面 + 交错的 UV 平面（编码器、采集卡常用）
+    I420    // Y 平面 + U 平面 + V 平面
+};
+
+// 4:2:0 平面YUV帧：各平面是指向调用方缓冲区的 cv::Mat 视图，构造时不复制像素
+// 亮度平面可直接作为灰度图用于人脸检测，只有需要彩色时（人脸裁剪、显示）才转换为BGR
+struct YuvFrame {
+    YuvLayout layout = YuvLayout::NV12;
+    cv::Mat y;    // CV_8UC1，width x height
+    cv::Mat uv;   // NV12：CV_8UC2，width/2 x height/2（U、V 交错）
+    cv::Mat u;    // I420：CV_8UC1，width/2 x height/2
+    cv::Mat v;    // I420：CV_8UC1，width/2 x height/2
+
+    int width() const { return y.cols; }
+    int height() const { return y.rows; }
+    bool empty() const { return y.empty(); }
+
+    // 按各平面构造（平面可带行跨度，如采集卡的对齐缓冲区）；尺寸不符时返回空帧
+    static YuvFrame fromNV12(const cv::Mat& y_plane, const cv::Mat& uv_plane);
+    static YuvFrame fromI420(const cv::Mat& y_plane, const cv::Mat& u_plane, const cv::Mat& v_plane);
+
+    // 包装 OpenCV 约定的单缓冲区布局：CV_8UC1，height*3/2 行 x width 列，行间连续
+    static YuvFrame wrap(const cv::Mat& buffer, YuvLayout layout);
+
+    // 包装连续内存（stride 为亮度行跨度，0 表示等于 width；色度平面紧随其后，行跨度按比例）
+    static YuvFrame wrap(uint8_t* data, int width, int height, YuvLayout layout, size_t stride = 0);
+};
+
+// 把 rect 区域转换为BGR：只打包并转换该区域（按色度采样网格扩展到偶数坐标，再裁回 rect）
+// rect 超出帧范围或帧为空时返回 false
+bool yuvCropToBgr(const YuvFrame& frame, const cv::Rect& rect, cv::Mat& bgr);
+
+// 整帧转换为BGR（用于显示或绘制结果）
+bool yuvToBgr(const YuvFrame& frame, cv::Mat& bgr);
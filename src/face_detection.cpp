@@ -1,42 +1,169 @@
 #include "face_detection.h"
+#include "haar_cascade.h"
 #include "utils.h"
+#include "trace.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/objdetect.hpp>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
 
 using namespace cv;
 using namespace std;
 
-std::vector<cv::Rect> detectFaces(const Mat& frame) {
-    CascadeClassifier face_cascade;
-    
-    // 使用工具函数获取模型路径
-    std::string haar_path = ::utils::getModelPath("haarcascade_frontalface_default.xml");
+namespace {
+
+// 解析后的级联模型文件（进程内只解析一次，各线程由它构建自己的分类器）
+std::once_flag g_cascadeOnce;
+std::unique_ptr<FileStorage> g_cascadeStorage;
+std::mutex g_cascadeReadMutex;
+
+FileStorage* getCascadeStorage() {
+    std::call_once(g_cascadeOnce, [] {
+        // 使用工具函数获取模型路径
+        std::string haar_path = ::utils::getModelPath("haarcascade_frontalface_default.xml");
+        std::unique_ptr<FileStorage> storage(new FileStorage(haar_path, FileStorage::READ));
+        if (!storage->isOpened()) {
+            cerr << "[FaceDet] 错误：无法读取人脸 Haar 级联分类器: " << haar_path << endl;
+            return;
+        }
+        g_cascadeStorage = std::move(storage);
+    });
+    return g_cascadeStorage.get();
+}
+
+std::atomic<CascadeBackend> g_cascadeBackend(CascadeBackend::OPENCV);
+
+// 扁平化级联（进程内只构建一次，检测时只读，所有线程共享）
+std::once_flag g_flatCascadeOnce;
+std::unique_ptr<HaarCascade> g_flatCascade;
+
+const HaarCascade* getFlatCascade() {
+    std::call_once(g_flatCascadeOnce, [] {
+        FileStorage* storage = getCascadeStorage();
+        if (!storage) {
+            return;
+        }
+        std::unique_ptr<HaarCascade> cascade(new HaarCascade());
+        std::lock_guard<std::mutex> lock(g_cascadeReadMutex);
+        if (!cascade->read(storage->getFirstTopLevelNode())) {
+            cerr << "[FaceDet] 扁平化级联加载失败，改用 OpenCV 级联分类器" << endl;
+            return;
+        }
+        g_flatCascade = std::move(cascade);
+    });
+    return g_flatCascade.get();
+}
+
+} // namespace
+
+void setCascadeBackend(CascadeBackend backend) {
+    g_cascadeBackend = backend;
+}
+
+CascadeBackend getCascadeBackend() {
+    return g_cascadeBackend;
+}
+
+bool preloadFaceCascade() {
+    if (!getCascadeStorage()) {
+        return false;
+    }
+    // 扁平化级联的展开也在预加载时完成
+    if (getCascadeBackend() == CascadeBackend::FLAT) {
+        getFlatCascade();
+    }
+    return true;
+}
+
+// 获取当前线程的人脸级联分类器（每个线程只构建一次，CascadeClassifier 不能跨线程共享）
+static CascadeClassifier* getFaceCascade() {
+    thread_local CascadeClassifier face_cascade;
+    thread_local bool loaded = false;
     
-    // 加载人脸 Haar 级联分类器
-    if (!face_cascade.load(haar_path)) {
-        cerr << "[FaceDet] 错误：无法加载人脸 Haar 级联分类器: " << haar_path << endl;
+    if (!loaded) {
+        FileStorage* storage = getCascadeStorage();
+        if (!storage) {
+            return nullptr;
+        }
+        
+        // 从已解析的节点构建分类器，不再重复解析XML
+        std::lock_guard<std::mutex> lock(g_cascadeReadMutex);
+        if (!face_cascade.read(storage->getFirstTopLevelNode())) {
+            cerr << "[FaceDet] 错误：无法加载人脸 Haar 级联分类器" << endl;
+            return nullptr;
+        }
+        loaded = true;
+    }
+    return &face_cascade;
+}
+
+std::vector<cv::Rect> detectFaces(const Mat& frame) {
+    return detectFaces(frame, DetectionParams());
+}
+
+std::vector<cv::Rect> detectFaces(const Mat& frame, const DetectionParams& params) {
+    TRACE_SPAN("detectFaces");
+    const HaarCascade* flat_cascade = getCascadeBackend() == CascadeBackend::FLAT ? getFlatCascade() : nullptr;
+    CascadeClassifier* face_cascade = flat_cascade ? nullptr : getFaceCascade();
+    if (!flat_cascade && !face_cascade) {
         return {};
     }
     
-    // 转换为灰度图像
+    // 转换为灰度图像（单通道输入，如YUV帧的亮度平面，直接使用，不复制）
     Mat gray;
-    cvtColor(frame, gray, COLOR_BGR2GRAY);
+    if (frame.channels() == 1) {
+        gray = frame;
+    } else {
+        cvtColor(frame, gray, COLOR_BGR2GRAY);
+    }
+    
+    // 按需缩小图像，降低检测开销
+    double scale = params.input_scale;
+    if (scale > 0.0 && scale < 1.0) {
+        resize(gray, gray, Size(), scale, scale, INTER_LINEAR);
+    } else {
+        scale = 1.0;
+    }
     
     // 直方图均衡化，提高检测效果
-    equalizeHist(gray, gray);
+    if (params.equalize_hist) {
+        // gray 仍指向调用方的单通道帧时不能原地均衡化
+        if (gray.data == frame.data) {
+            Mat equalized;
+            equalizeHist(gray, equalized);
+            gray = equalized;
+        } else {
+            equalizeHist(gray, gray);
+        }
+    }
     
     // 检测人脸
     vector<Rect> faces;
-    face_cascade.detectMultiScale(
-        gray,           // 输入图像
-        faces,          // 输出人脸区域
-        1.1,            // 缩放因子
-        3,              // 最小邻居数
-        0,              // 标志
-        Size(30, 30)    // 最小人脸尺寸
-    );
+    Size min_size(cvRound(params.min_size.width * scale), cvRound(params.min_size.height * scale));
+    if (flat_cascade) {
+        flat_cascade->detectMultiScale(gray, faces, params.scale_factor, params.min_neighbors, min_size);
+    } else {
+        face_cascade->detectMultiScale(
+            gray,                                   // 输入图像
+            faces,                                  // 输出人脸区域
+            params.scale_factor,                    // 缩放因子
+            params.min_neighbors,                   // 最小邻居数
+            0,                                      // 标志
+            min_size                                // 最小人脸尺寸
+        );
+    }
+    
+    // 映射回原图坐标
+    if (scale != 1.0) {
+        for (auto& face : faces) {
+            face = Rect(cvRound(face.x / scale), cvRound(face.y / scale),
+                        cvRound(face.width / scale), cvRound(face.height / scale)) &
+                   Rect(0, 0, frame.cols, frame.rows);
+        }
+    }
     
     // 输出检测结果
     if (!faces.empty()) {
@@ -44,4 +171,4 @@ std::vector<cv::Rect> detectFaces(const Mat& frame) {
     }
     
     return faces;
-}
\ No newline at end of file
+}
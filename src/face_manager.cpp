@@ -1,8 +1,13 @@
 #include "face_manager.h"
 #include "face_detection.h"
 #include "face_recognition.h"
+#include "label_table.h"
+#include "tiered_gallery.h"
+#include "utils.h"
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <algorithm>
 
 using namespace std::filesystem;
@@ -38,13 +43,17 @@ bool FaceManager::autoScanAndRegister() {
     // 清空之前的数据
     known_features_.clear();
     known_labels_.clear();
+    known_label_ids_.clear();
+    identities_.clear();
+    identity_index_.clear();
     
     if (!autoScanPicturesDirectory()) {
         std::cerr << "[FaceManager] 自动扫描失败" << std::endl;
         return false;
     }
     
-    std::cout << "[FaceManager] 自动扫描完成，成功注册 " << known_features_.size() << " 个人脸" << std::endl;
+    std::cout << "[FaceManager] 自动扫描完成，成功注册 " << known_features_.size() << " 个人脸, "
+              << identities_.size() << " 个身份" << std::endl;
     return true;
 }
 
@@ -56,14 +65,34 @@ const std::vector<std::string>& FaceManager::getKnownLabels() const {
     return known_labels_;
 }
 
+const std::vector<uint32_t>& FaceManager::getKnownLabelIds() const {
+    return known_label_ids_;
+}
+
+const std::vector<FaceIdentity>& FaceManager::getIdentities() const {
+    return identities_;
+}
+
 size_t FaceManager::getRegisteredCount() const {
     return known_features_.size();
 }
 
+size_t FaceManager::getIdentityCount() const {
+    return identities_.size();
+}
+
 bool FaceManager::isInitialized() const {
     return initialized_;
 }
 
+bool FaceManager::exportGallery(const std::string& path) const {
+    if (known_features_.empty()) {
+        std::cerr << "[FaceManager] 错误：没有可导出的人脸" << std::endl;
+        return false;
+    }
+    return TieredGallery::writeColdStore(path, known_features_, known_labels_);
+}
+
 bool FaceManager::enrollFromImage(const std::string& img_path, 
                                  const std::string& label,
                                  cv::Mat& outFeatures) {
@@ -93,50 +122,63 @@ bool FaceManager::enrollFromImage(const std::string& img_path,
 bool FaceManager::autoScanPicturesDirectory() {
     // 支持的图片格式
     std::vector<std::string> supported_extensions = {".jpg", ".jpeg", ".png", ".bmp"};
+    auto isSupportedImage = [&](const path& p) {
+        std::string extension = p.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        return std::find(supported_extensions.begin(), supported_extensions.end(), extension) != supported_extensions.end();
+    };
+    
+    // 可选的标签映射文件：多张照片可以映射到同一个人
+    auto label_mapping = loadLabelMapping((path(pictures_directory_) / "labels.txt").string());
     
     int total_files = 0;
     int success_count = 0;
     
-    // 遍历目录中的所有文件
+    auto enrollFile = [&](const path& file, const std::string& label) {
+        total_files++;
+        std::cout << "[FaceManager] 处理文件: " << file.filename().string() << std::endl;
+        
+        // 尝试注册人脸
+        cv::Mat features;
+        if (enrollFromImage(file.string(), label, features)) {
+            addSample(label, features);
+            success_count++;
+            std::cout << "[FaceManager] ✓ " << label << " 注册成功" << std::endl;
+        } else {
+            std::cout << "[FaceManager] ✗ " << label << " 注册失败" << std::endl;
+        }
+    };
+    
+    // 遍历目录：文件按文件名（或映射）取标签，子目录按目录名取标签（每人一个目录）
     for (const auto& entry : directory_iterator(pictures_directory_)) {
-        if (entry.is_regular_file()) {
-            std::string filename = entry.path().filename().string();
-            std::string filepath = entry.path().string();
-            
-            // 检查文件扩展名
-            std::string extension = entry.path().extension().string();
-            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-            
-            if (std::find(supported_extensions.begin(), supported_extensions.end(), extension) != supported_extensions.end()) {
-                total_files++;
-                std::cout << "[FaceManager] 处理文件: " << filename << std::endl;
-                
-                // 从文件名提取标签（去掉扩展名）
-                std::string label = entry.path().stem().string();
-                
-                // 尝试注册人脸
-                cv::Mat features;
-                if (enrollFromImage(filepath, label, features)) {
-                    known_features_.push_back(features);
-                    known_labels_.push_back(label);
-                    success_count++;
-                    std::cout << "[FaceManager] ✓ " << label << " 注册成功" << std::endl;
-                } else {
-                    std::cout << "[FaceManager] ✗ " << label << " 注册失败" << std::endl;
+        if (entry.is_directory()) {
+            std::string label = entry.path().filename().string();
+            for (const auto& sample : directory_iterator(entry.path())) {
+                if (sample.is_regular_file() && isSupportedImage(sample.path())) {
+                    enrollFile(sample.path(), label);
                 }
             }
+        } else if (entry.is_regular_file() && isSupportedImage(entry.path())) {
+            // 从映射文件或文件名提取标签（去掉扩展名）
+            std::string filename = entry.path().filename().string();
+            auto mapped = label_mapping.find(filename);
+            std::string label = mapped != label_mapping.end() ? mapped->second : entry.path().stem().string();
+            enrollFile(entry.path(), label);
         }
     }
     
+    buildCentroids();
+    
     std::cout << "\n[FaceManager] 扫描完成！" << std::endl;
     std::cout << "[FaceManager] 总文件数: " << total_files << std::endl;
     std::cout << "[FaceManager] 成功注册: " << success_count << std::endl;
     std::cout << "[FaceManager] 失败数量: " << (total_files - success_count) << std::endl;
     
     if (success_count > 0) {
-        std::cout << "[FaceManager] 已注册的人脸:" << std::endl;
-        for (size_t i = 0; i < known_labels_.size(); ++i) {
-            std::cout << "  " << (i+1) << ". " << known_labels_[i] << std::endl;
+        std::cout << "[FaceManager] 已注册的身份:" << std::endl;
+        for (size_t i = 0; i < identities_.size(); ++i) {
+            std::cout << "  " << (i+1) << ". " << identities_[i].label
+                      << " (" << identities_[i].samples.size() << " 个样本)" << std::endl;
         }
         return true;
     } else {
@@ -144,3 +186,58 @@ bool FaceManager::autoScanPicturesDirectory() {
         return false;
     }
 }
+
+std::unordered_map<std::string, std::string> FaceManager::loadLabelMapping(const std::string& mapping_path) const {
+    std::unordered_map<std::string, std::string> mapping;
+    std::ifstream in(mapping_path);
+    if (!in) {
+        return mapping;
+    }
+    
+    std::string line;
+    while (std::getline(in, line)) {
+        // 跳过空行和注释
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string filename, label;
+        if (fields >> filename >> label) {
+            mapping[filename] = label;
+        }
+    }
+    
+    std::cout << "[FaceManager] 读取标签映射: " << mapping_path << " (" << mapping.size() << " 条)" << std::endl;
+    return mapping;
+}
+
+void FaceManager::addSample(const std::string& label, const cv::Mat& features) {
+    known_features_.push_back(features);
+    known_labels_.push_back(label);
+    known_label_ids_.push_back(LabelTable::global().intern(label));
+    
+    auto it = identity_index_.find(label);
+    if (it == identity_index_.end()) {
+        it = identity_index_.emplace(label, identities_.size()).first;
+        identities_.push_back(FaceIdentity());
+        identities_.back().label = label;
+        identities_.back().label_id = known_label_ids_.back();
+    }
+    identities_[it->second].samples.push_back(features);
+}
+
+void FaceManager::buildCentroids() {
+    for (auto& identity : identities_) {
+        // 平均前先归一化，避免某个样本的幅值主导平均模板
+        cv::Mat sum = cv::Mat::zeros(1, (int)identity.samples[0].total(), CV_32F);
+        for (const auto& sample : identity.samples) {
+            cv::Mat flat;
+            sample.reshape(1, 1).convertTo(flat, CV_32F);
+            double norm = cv::norm(flat);
+            if (norm > 1e-10) {
+                sum += flat / norm;
+            }
+        }
+        identity.centroid = sum / (double)identity.samples.size();
+    }
+}
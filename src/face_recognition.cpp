@@ -1,7 +1,13 @@
 #include "face_recognition.h"
 #include "utils.h"
+#include "trace.h"
+#include "thread_pool.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 
 using namespace cv;
@@ -10,6 +16,119 @@ using namespace std;
 // 全局实例
 static FaceRecognition* g_faceRecognition = nullptr;
 
+namespace {
+
+// 批量提取：一批人脸的同一像素相邻存放（[像素][通道][人脸]），逐像素计算时内层循环跨人脸，
+// 8个float恰好占满一个AVX寄存器，由编译器自动向量化
+const int kBatchTileSize = 112;   // 与 inputSize 一致
+const int kBatchTilePixels = kBatchTileSize * kBatchTileSize;
+const size_t kBatchLanes = 8;
+
+// 像素采样特征的步长（与 extractSimpleFeatures 相同）
+const int kSampleStep = std::max(1, kBatchTileSize / 16);
+
+// cv::cartToPolar 计算角度使用的 atan2 多项式近似（单位：度）
+const float kAtanP1 = 0.9997878412794807f * (float)(180 / CV_PI);
+const float kAtanP3 = -0.3258083974640975f * (float)(180 / CV_PI);
+const float kAtanP5 = 0.1555786518463281f * (float)(180 / CV_PI);
+const float kAtanP7 = -0.04432655554792128f * (float)(180 / CV_PI);
+const float kDegreesToRadians = (float)(CV_PI / 180);
+
+// 单个线程的批处理工作区，按线程复用
+struct BatchWorkspace {
+    std::vector<uint8_t> bgr;     // 均衡化后的像素，[像素][通道][人脸]
+    std::vector<float> gray;      // 灰度，[像素][人脸]
+    std::vector<uint8_t> gray8;   // 单张人脸的8位灰度图块（供 Canny 使用）
+    cv::Mat tile;
+    cv::Mat edges;
+
+    BatchWorkspace()
+        : bgr(kBatchTilePixels * 3 * kBatchLanes),
+          gray(kBatchTilePixels * kBatchLanes),
+          gray8(kBatchTilePixels) {
+    }
+};
+
+// 与 cv::equalizeHist 相同的映射表
+void equalizeLut(const int* hist, int total, uint8_t* lut) {
+    int i = 0;
+    while (!hist[i]) {
+        ++i;
+    }
+    if (hist[i] == total) {
+        std::fill(lut, lut + 256, (uint8_t)i);
+        return;
+    }
+    float scale = 255.0f / (total - hist[i]);
+    int sum = 0;
+    for (lut[i++] = 0; i < 256; ++i) {
+        sum += hist[i];
+        lut[i] = cv::saturate_cast<uchar>(sum * scale);
+    }
+}
+
+// 缩放人脸并逐通道直方图均衡化，写入工作区的第 lane 个人脸通道；face 为空时填0
+// sum_b / sumsq_b 返回均衡化后B通道的像素和与平方和（由直方图和映射表精确得到）
+void loadBatchTile(const cv::Mat* face, size_t lane, BatchWorkspace& ws, double& sum_b, double& sumsq_b) {
+    uint8_t* dst = ws.bgr.data() + lane;
+    sum_b = 0.0;
+    sumsq_b = 0.0;
+    if (!face) {
+        for (int i = 0; i < kBatchTilePixels * 3; ++i) {
+            dst[i * kBatchLanes] = 0;
+        }
+        return;
+    }
+
+    cv::resize(*face, ws.tile, cv::Size(kBatchTileSize, kBatchTileSize));
+    const uint8_t* src = ws.tile.ptr<uint8_t>();
+
+    int hist[3][256] = {};
+    for (int i = 0; i < kBatchTilePixels; ++i) {
+        hist[0][src[i * 3]]++;
+        hist[1][src[i * 3 + 1]]++;
+        hist[2][src[i * 3 + 2]]++;
+    }
+    uint8_t lut[3][256];
+    for (int c = 0; c < 3; ++c) {
+        equalizeLut(hist[c], kBatchTilePixels, lut[c]);
+    }
+    for (int v = 0; v < 256; ++v) {
+        sum_b += (double)hist[0][v] * lut[0][v];
+        sumsq_b += (double)hist[0][v] * lut[0][v] * lut[0][v];
+    }
+    for (int i = 0; i < kBatchTilePixels; ++i) {
+        dst[(i * 3) * kBatchLanes] = lut[0][src[i * 3]];
+        dst[(i * 3 + 1) * kBatchLanes] = lut[1][src[i * 3 + 1]];
+        dst[(i * 3 + 2) * kBatchLanes] = lut[2][src[i * 3 + 2]];
+    }
+}
+
+// 第 k 张人脸一个像素的增强后BGR值、灰度（COLOR_BGR2GRAY 系数）与饱和度（COLOR_BGR2HSV 的S通道）
+struct BatchPixel {
+    float b, g, r, gray, sat;
+};
+
+inline BatchPixel batchPixel(const uint8_t* px, size_t k,
+                             const float (*scale)[kBatchLanes], const float (*offset)[kBatchLanes]) {
+    BatchPixel p;
+    p.b = px[k] * scale[0][k] + offset[0][k];
+    p.g = px[kBatchLanes + k] * scale[1][k] + offset[1][k];
+    p.r = px[2 * kBatchLanes + k] * scale[2][k] + offset[2][k];
+    p.gray = p.b * 0.114f + p.g * 0.587f + p.r * 0.299f;
+    float vmax = std::max(p.b, std::max(p.g, p.r));
+    float vmin = std::min(p.b, std::min(p.g, p.r));
+    p.sat = (vmax - vmin) / (std::abs(vmax) + FLT_EPSILON);
+    return p;
+}
+
+double laneStd(double sum, double sumsq, double count) {
+    double mean = sum / count;
+    return std::sqrt(std::max(0.0, sumsq / count - mean * mean));
+}
+
+} // namespace
+
 FaceRecognition::FaceRecognition() : initialized(false), inputSize(112, 112), featureDimension(128) {
 }
 
@@ -32,6 +151,7 @@ bool FaceRecognition::isInitialized() const {
 }
 
 cv::Mat FaceRecognition::preprocessFace(const cv::Mat& face) {
+    TRACE_SPAN("preprocessFace");
     cv::Mat processed;
     
     // 1. 调整图像尺寸
@@ -79,6 +199,7 @@ cv::Mat FaceRecognition::preprocessFace(const cv::Mat& face) {
 }
 
 cv::Mat FaceRecognition::extractSimpleFeatures(const cv::Mat& processedFace) {
+    TRACE_SPAN("extractSimpleFeatures");
     std::vector<float> features;
     
     // 1. BGR通道统计特征 (权重: 1.2 - 重要特征)
@@ -162,6 +283,13 @@ cv::Mat FaceRecognition::extractSimpleFeatures(const cv::Mat& processedFace) {
     double edge_density = cv::countNonZero(edges) / (double)(edges.rows * edges.cols);
     features.push_back(edge_density * 1.2f); // 边缘密度权重恢复到1.2
     
+    cv::Mat smoothedFeatures = finalizeFeatures(features);
+    
+    std::cout << "[FaceRec] 提取了 " << features.size() << " 维加权特征 + 安全优化" << std::endl;
+    return smoothedFeatures;
+}
+
+cv::Mat FaceRecognition::finalizeFeatures(std::vector<float>& features) const {
     // 确保特征向量达到指定维度
     while (features.size() < featureDimension) {
         features.push_back(0.0f);
@@ -184,8 +312,6 @@ cv::Mat FaceRecognition::extractSimpleFeatures(const cv::Mat& processedFace) {
     // 安全优化2: 轻微平滑处理 - 减少噪声影响
     cv::Mat smoothedFeatures;
     cv::GaussianBlur(normalizedFeatures, smoothedFeatures, cv::Size(1, 3), 0.5);
-    
-    std::cout << "[FaceRec] 提取了 " << features.size() << " 维加权特征 + 安全优化" << std::endl;
     return smoothedFeatures;
 }
 
@@ -233,6 +359,242 @@ std::vector<cv::Mat> FaceRecognition::extractFaceFeatures(
     return descriptors;
 }
 
+void FaceRecognition::extractBatchGroup(const cv::Mat* const* faces, size_t count, cv::Mat* results) const {
+    TRACE_SPAN("extractBatchGroup");
+    thread_local BatchWorkspace ws;
+    const size_t L = kBatchLanes;
+    const double N = kBatchTilePixels;
+
+    // 1. 缩放与直方图均衡化，各人脸写入自己的通道（空位补0）
+    // 每张人脸记一个 batchPreprocessFace，对应逐张提取中的 preprocessFace
+    double sum_b[kBatchLanes];
+    double sumsq_b[kBatchLanes];
+    for (size_t k = 0; k < L; ++k) {
+        if (k < count && faces[k]) {
+            TRACE_SPAN("batchPreprocessFace");
+            loadBatchTile(faces[k], k, ws, sum_b[k], sumsq_b[k]);
+        } else {
+            loadBatchTile(nullptr, k, ws, sum_b[k], sumsq_b[k]);
+        }
+    }
+
+    // 2. 对比度增强按增强前B通道的均值与标准差判定，增强与归一化合并为每通道一次乘加：
+    //    processed = x * scale + offset
+    // 单张提取中 (enhanced - mean) * 1.3 + mean 的标量只作用于B通道，G/R通道只做缩放，这里保持一致
+    float scale[3][kBatchLanes];
+    float offset[3][kBatchLanes];
+    for (size_t k = 0; k < L; ++k) {
+        double mean = sum_b[k] / N;
+        bool enhance = laneStd(sum_b[k], sumsq_b[k], N) < 50.0;
+        double gain = enhance ? 1.3 : 1.0;
+        for (int c = 0; c < 3; ++c) {
+            scale[c][k] = (float)(gain / 255.0);
+            offset[c][k] = (c == 0 && enhance) ? (float)((mean - mean * gain) / 255.0) : 0.0f;
+        }
+    }
+
+    // 3. BGR、灰度与饱和度统计；行内用float累加，逐行汇总到double
+    // 各统计量先减去该人脸首个像素的值再累加，避免低对比度人脸的方差被 sumsq/N - mean^2 的抵消误差淹没
+    enum { B, G, R, GRAY, SAT, MAG, ANG, STAT_COUNT };
+    double sum[STAT_COUNT][kBatchLanes] = {};     // B…SAT 为减去偏移后的和
+    double sumsq[STAT_COUNT][kBatchLanes] = {};
+    float shift[SAT + 1][kBatchLanes];
+    for (size_t k = 0; k < L; ++k) {
+        BatchPixel p = batchPixel(ws.bgr.data(), k, scale, offset);
+        shift[B][k] = p.b;
+        shift[G][k] = p.g;
+        shift[R][k] = p.r;
+        shift[GRAY][k] = p.gray;
+        shift[SAT][k] = p.sat;
+    }
+    for (int y = 0; y < kBatchTileSize; ++y) {
+        float row_sum[SAT + 1][kBatchLanes] = {};
+        float row_sumsq[SAT + 1][kBatchLanes] = {};
+        for (int x = 0; x < kBatchTileSize; ++x) {
+            int i = y * kBatchTileSize + x;
+            const uint8_t* px = &ws.bgr[i * 3 * L];
+            float gray[kBatchLanes];
+            for (size_t k = 0; k < L; ++k) {
+                BatchPixel p = batchPixel(px, k, scale, offset);
+                gray[k] = p.gray;
+                float db = p.b - shift[B][k];
+                float dg = p.g - shift[G][k];
+                float dr = p.r - shift[R][k];
+                float dv = p.gray - shift[GRAY][k];
+                float ds = p.sat - shift[SAT][k];
+                row_sum[B][k] += db;
+                row_sum[G][k] += dg;
+                row_sum[R][k] += dr;
+                row_sum[GRAY][k] += dv;
+                row_sum[SAT][k] += ds;
+                row_sumsq[B][k] += db * db;
+                row_sumsq[G][k] += dg * dg;
+                row_sumsq[R][k] += dr * dr;
+                row_sumsq[GRAY][k] += dv * dv;
+                row_sumsq[SAT][k] += ds * ds;
+            }
+            std::copy(gray, gray + L, &ws.gray[i * L]);
+        }
+        for (int stat = B; stat <= SAT; ++stat) {
+            for (size_t k = 0; k < L; ++k) {
+                sum[stat][k] += row_sum[stat][k];
+                sumsq[stat][k] += row_sumsq[stat][k];
+            }
+        }
+    }
+    double mean[SAT + 1][kBatchLanes];
+    for (int stat = B; stat <= SAT; ++stat) {
+        for (size_t k = 0; k < L; ++k) {
+            mean[stat][k] = shift[stat][k] + sum[stat][k] / N;
+        }
+    }
+
+    // 4. Sobel 梯度幅值与方向（边界按 BORDER_REFLECT_101）
+    for (int y = 0; y < kBatchTileSize; ++y) {
+        int ym = y == 0 ? 1 : y - 1;
+        int yp = y == kBatchTileSize - 1 ? kBatchTileSize - 2 : y + 1;
+        const float* r0 = &ws.gray[ym * kBatchTileSize * L];
+        const float* r1 = &ws.gray[y * kBatchTileSize * L];
+        const float* r2 = &ws.gray[yp * kBatchTileSize * L];
+        float row_mag[kBatchLanes] = {};
+        float row_ang[kBatchLanes] = {};
+        for (int x = 0; x < kBatchTileSize; ++x) {
+            size_t xm = (x == 0 ? 1 : x - 1) * L;
+            size_t xc = x * L;
+            size_t xp = (x == kBatchTileSize - 1 ? kBatchTileSize - 2 : x + 1) * L;
+            for (size_t k = 0; k < L; ++k) {
+                float gx = (r0[xp + k] + 2.0f * r1[xp + k] + r2[xp + k]) -
+                           (r0[xm + k] + 2.0f * r1[xm + k] + r2[xm + k]);
+                float gy = (r2[xm + k] + 2.0f * r2[xc + k] + r2[xp + k]) -
+                           (r0[xm + k] + 2.0f * r0[xc + k] + r0[xp + k]);
+                // 象限选择写成 0/1 系数的乘加（结果与条件分支完全相同），循环内没有分支才能向量化
+                float ax = std::abs(gx);
+                float ay = std::abs(gy);
+                float steep = (float)(ax < ay);
+                float neg_x = (float)(gx < 0);
+                float neg_y = (float)(gy < 0);
+                float c = (steep * ax + (1.0f - steep) * ay) /
+                          (steep * ay + (1.0f - steep) * ax + (float)DBL_EPSILON);
+                float c2 = c * c;
+                float a = (((kAtanP7 * c2 + kAtanP5) * c2 + kAtanP3) * c2 + kAtanP1) * c;
+                a = 90.0f * steep + a * (1.0f - 2.0f * steep);
+                a = 180.0f * neg_x + a * (1.0f - 2.0f * neg_x);
+                a = 360.0f * neg_y + a * (1.0f - 2.0f * neg_y);
+                row_mag[k] += std::sqrt(gx * gx + gy * gy);
+                row_ang[k] += a * kDegreesToRadians;
+            }
+        }
+        for (size_t k = 0; k < L; ++k) {
+            sum[MAG][k] += row_mag[k];
+            sum[ANG][k] += row_ang[k];
+        }
+    }
+
+    // 5. 逐人脸计算边缘密度并按 extractSimpleFeatures 的顺序与权重组装特征
+    // Canny 是逐人脸的边缘跟踪，按人脸取出8位灰度图块后调用 OpenCV；
+    // 跨人脸的统计（第2~4步）无法拆到单张人脸，每张人脸只记这一步的 batchFaceFeatures
+    std::vector<float> features;
+    features.reserve(featureDimension);
+    for (size_t k = 0; k < count; ++k) {
+        if (!faces[k]) {
+            continue;
+        }
+        TRACE_SPAN("batchFaceFeatures");
+        for (int i = 0; i < kBatchTilePixels; ++i) {
+            ws.gray8[i] = cv::saturate_cast<uchar>(ws.gray[i * L + k] * 255.0f);
+        }
+        cv::Mat gray8_tile(kBatchTileSize, kBatchTileSize, CV_8U, ws.gray8.data());
+        cv::Canny(gray8_tile, ws.edges, 30.0, 120.0);
+        double edge_density = cv::countNonZero(ws.edges) / N;
+
+        features.clear();
+        for (int c = B; c <= R; ++c) {
+            features.push_back(mean[c][k] * 1.2f);
+        }
+        for (int c = B; c <= R; ++c) {
+            features.push_back(laneStd(sum[c][k], sumsq[c][k], N) * 1.0f);
+        }
+        features.push_back(laneStd(sum[GRAY][k], sumsq[GRAY][k], N) * 1.5f);
+        features.push_back(mean[GRAY][k] * 1.5f);
+        features.push_back(mean[SAT][k] * 1.3f);
+        features.push_back(laneStd(sum[SAT][k], sumsq[SAT][k], N) * 1.3f);
+
+        for (int y = 0; y < kBatchTileSize; y += kSampleStep) {
+            for (int x = 0; x < kBatchTileSize; x += kSampleStep) {
+                if (features.size() < (size_t)featureDimension - 10) {
+                    BatchPixel p = batchPixel(&ws.bgr[(y * kBatchTileSize + x) * 3 * L], k, scale, offset);
+                    features.push_back((p.b + p.g + p.r) / 3.0f * 1.1f);
+                }
+            }
+        }
+
+        features.push_back(sum[MAG][k] / N * 1.4f);
+        features.push_back(sum[ANG][k] / N * 1.4f);
+        features.push_back(edge_density * 1.2f);
+        results[k] = finalizeFeatures(features);
+    }
+}
+
+std::vector<cv::Mat> FaceRecognition::extractFaceFeaturesBatch(
+    const std::vector<cv::Mat>& faceImages,
+    ThreadPool* pool) {
+    
+    std::vector<cv::Mat> results(faceImages.size());
+    if (!initialized) {
+        std::cerr << "[FaceRec] 系统未初始化，请先调用 initialize()" << std::endl;
+        return results;
+    }
+    TRACE_SPAN("extractFeaturesBatch");
+    
+    // 只接受8位BGR图像，其余人脸结果留空
+    std::vector<const cv::Mat*> faces(faceImages.size(), nullptr);
+    for (size_t i = 0; i < faceImages.size(); ++i) {
+        if (!faceImages[i].empty() && faceImages[i].type() == CV_8UC3) {
+            faces[i] = &faceImages[i];
+        } else {
+            std::cerr << "[FaceRec] 第 " << i << " 张人脸不是8位BGR图像，跳过" << std::endl;
+        }
+    }
+    
+    // 每 kBatchLanes 张人脸一批，各批互相独立
+    size_t groups = (faces.size() + kBatchLanes - 1) / kBatchLanes;
+    auto runGroup = [&](size_t group) {
+        size_t begin = group * kBatchLanes;
+        size_t count = std::min(kBatchLanes, faces.size() - begin);
+        try {
+            extractBatchGroup(&faces[begin], count, &results[begin]);
+        } catch (const cv::Exception& e) {
+            std::cerr << "[FaceRec] 批量特征提取失败: " << e.what() << std::endl;
+            std::fill(results.begin() + begin, results.begin() + begin + count, cv::Mat());
+        }
+    };
+    
+    if (pool && groups > 1) {
+        pool->parallelFor(groups, runGroup);
+    } else {
+        for (size_t group = 0; group < groups; ++group) {
+            runGroup(group);
+        }
+    }
+    return results;
+}
+
+std::vector<cv::Mat> FaceRecognition::extractFaceFeaturesBatch(
+    const cv::Mat& frame,
+    const std::vector<cv::Rect>& faces,
+    ThreadPool* pool) {
+    
+    // 超出图像范围的人脸框与逐张提取一样视为失败
+    const cv::Rect bounds(0, 0, frame.cols, frame.rows);
+    std::vector<cv::Mat> crops(faces.size());
+    for (size_t i = 0; i < faces.size(); ++i) {
+        if (!faces[i].empty() && (faces[i] & bounds) == faces[i]) {
+            crops[i] = frame(faces[i]);
+        }
+    }
+    return extractFaceFeaturesBatch(crops, pool);
+}
+
 bool FaceRecognition::compareFaces(
     const cv::Mat& face1, 
     const cv::Mat& face2, 
@@ -282,6 +644,31 @@ std::vector<cv::Mat> extract_face_features(
     return g_faceRecognition->extractFaceFeatures(frame, faces);
 }
 
+std::vector<cv::Mat> extract_face_features_batch(
+    const std::vector<cv::Mat>& faceImages,
+    ThreadPool* pool) {
+    
+    if (!g_faceRecognition || !g_faceRecognition->isInitialized()) {
+        std::cerr << "[FaceRec] 系统未初始化，请先调用 load_model()" << std::endl;
+        return std::vector<cv::Mat>(faceImages.size());
+    }
+    
+    return g_faceRecognition->extractFaceFeaturesBatch(faceImages, pool);
+}
+
+std::vector<cv::Mat> extract_face_features_batch(
+    const cv::Mat& frame,
+    const std::vector<cv::Rect>& faces,
+    ThreadPool* pool) {
+    
+    if (!g_faceRecognition || !g_faceRecognition->isInitialized()) {
+        std::cerr << "[FaceRec] 系统未初始化，请先调用 load_model()" << std::endl;
+        return std::vector<cv::Mat>(faces.size());
+    }
+    
+    return g_faceRecognition->extractFaceFeaturesBatch(frame, faces, pool);
+}
+
 double compare_faces(
     const cv::Mat& face1, 
     const cv::Mat& face2, 
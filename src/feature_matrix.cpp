@@ -0,0 +1,195 @@
+#include "feature_matrix.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+
+FeatureMatrix::FeatureMatrix() : rows_(0), dimension_(0) {
+}
+
+FeatureMatrix::FeatureMatrix(size_t rows, int dimension)
+    : rows_(rows), dimension_(dimension), data_(rows * dimension, 0.0f) {
+}
+
+FeatureMatrix FeatureMatrix::fromMats(const std::vector<cv::Mat>& features) {
+    if (features.empty()) {
+        return FeatureMatrix();
+    }
+
+    int dimension = (int)features[0].total();
+    FeatureMatrix matrix(features.size(), dimension);
+    for (size_t i = 0; i < features.size(); ++i) {
+        if ((int)features[i].total() != dimension) {
+            std::cerr << "[FeatureMatrix] 错误：第 " << i << " 个特征维度不一致" << std::endl;
+            return FeatureMatrix();
+        }
+        cv::Mat row;
+        features[i].reshape(1, 1).convertTo(row, CV_32F);
+        std::copy(row.ptr<float>(), row.ptr<float>() + dimension, matrix.row(i));
+    }
+    matrix.normalizeRows();
+    return matrix;
+}
+
+FeatureMatrix FeatureMatrix::fromRows(const float* data, size_t rows, int dimension) {
+    FeatureMatrix matrix(rows, dimension);
+    std::copy(data, data + rows * dimension, matrix.data_.begin());
+    matrix.normalizeRows();
+    return matrix;
+}
+
+void FeatureMatrix::normalizeRows() {
+    for (size_t i = 0; i < rows_; ++i) {
+        float* r = row(i);
+        double norm = 0.0;
+        for (int d = 0; d < dimension_; ++d) {
+            norm += (double)r[d] * r[d];
+        }
+        if (norm > 0.0) {
+            float inv = (float)(1.0 / std::sqrt(norm));
+            for (int d = 0; d < dimension_; ++d) {
+                r[d] *= inv;
+            }
+        }
+    }
+}
+
+void similarityTile(const FeatureMatrix& a, size_t a_begin, size_t a_end,
+                    const FeatureMatrix& b, size_t b_begin, size_t b_end,
+                    float* out) {
+    const int dim = a.dimension();
+    const size_t width = b_end - b_begin;
+
+    // 转置 b 块：bt[d][j]，使内层循环沿 j 连续访问，编译器可按 SIMD 宽度展开
+    thread_local std::vector<float> transposed;
+    transposed.resize((size_t)dim * width);
+    for (size_t j = 0; j < width; ++j) {
+        const float* src = b.row(b_begin + j);
+        for (int d = 0; d < dim; ++d) {
+            transposed[(size_t)d * width + j] = src[d];
+        }
+    }
+
+    // 每次处理 4 行 a，bt 的每次加载复用 4 次
+    size_t i = a_begin;
+    for (; i + 4 <= a_end; i += 4) {
+        const float* __restrict a0 = a.row(i);
+        const float* __restrict a1 = a.row(i + 1);
+        const float* __restrict a2 = a.row(i + 2);
+        const float* __restrict a3 = a.row(i + 3);
+        float* __restrict acc0 = out + (i - a_begin) * width;
+        float* __restrict acc1 = acc0 + width;
+        float* __restrict acc2 = acc1 + width;
+        float* __restrict acc3 = acc2 + width;
+        std::fill(acc0, acc0 + 4 * width, 0.0f);
+        for (int d = 0; d < dim; ++d) {
+            const float v0 = a0[d], v1 = a1[d], v2 = a2[d], v3 = a3[d];
+            const float* __restrict bt = transposed.data() + (size_t)d * width;
+            for (size_t j = 0; j < width; ++j) {
+                const float b = bt[j];
+                acc0[j] += v0 * b;
+                acc1[j] += v1 * b;
+                acc2[j] += v2 * b;
+                acc3[j] += v3 * b;
+            }
+        }
+    }
+    for (; i < a_end; ++i) {
+        const float* __restrict ai = a.row(i);
+        float* __restrict acc = out + (i - a_begin) * width;
+        std::fill(acc, acc + width, 0.0f);
+        for (int d = 0; d < dim; ++d) {
+            const float value = ai[d];
+            const float* __restrict bt = transposed.data() + (size_t)d * width;
+            for (size_t j = 0; j < width; ++j) {
+                acc[j] += value * bt[j];
+            }
+        }
+    }
+}
+
+AllPairsStats forEachTile(const FeatureMatrix& matrix, ThreadPool& pool, const TileVisitor& visit,
+                          size_t block) {
+    AllPairsStats stats;
+    const size_t n = matrix.rows();
+    if (n < 2) {
+        return stats;
+    }
+    block = std::max<size_t>(8, block);
+
+    // 上三角块列表（bi <= bj），按块下标并行
+    const size_t blocks = (n + block - 1) / block;
+    std::vector<std::pair<uint32_t, uint32_t>> tiles;
+    tiles.reserve(blocks * (blocks + 1) / 2);
+    for (size_t bi = 0; bi < blocks; ++bi) {
+        for (size_t bj = bi; bj < blocks; ++bj) {
+            tiles.push_back(std::make_pair((uint32_t)bi, (uint32_t)bj));
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(tiles.size(), [&](size_t t) {
+        thread_local std::vector<float> scores;
+
+        size_t a_begin = (size_t)tiles[t].first * block;
+        size_t a_end = std::min(n, a_begin + block);
+        size_t b_begin = (size_t)tiles[t].second * block;
+        size_t b_end = std::min(n, b_begin + block);
+
+        scores.resize((a_end - a_begin) * (b_end - b_begin));
+        similarityTile(matrix, a_begin, a_end, matrix, b_begin, b_end, scores.data());
+        visit(a_begin, a_end, b_begin, b_end, scores.data());
+    });
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.tiles = tiles.size();
+    stats.pairs_compared = (uint64_t)n * (n - 1) / 2;
+    // 每个块按完整矩形计算（对角块也是），乘加计为 2 次浮点运算
+    double computed = 0.0;
+    for (const auto& tile : tiles) {
+        size_t rows = std::min(n, ((size_t)tile.first + 1) * block) - (size_t)tile.first * block;
+        size_t cols = std::min(n, ((size_t)tile.second + 1) * block) - (size_t)tile.second * block;
+        computed += (double)rows * cols;
+    }
+    stats.gflops = stats.seconds > 0.0 ? computed * 2.0 * matrix.dimension() / stats.seconds / 1e9 : 0.0;
+    return stats;
+}
+
+AllPairsStats forEachSimilarPair(const FeatureMatrix& matrix,
+                                 float threshold,
+                                 ThreadPool& pool,
+                                 const std::function<void(const std::vector<SimilarPair>&)>& sink,
+                                 size_t block) {
+    std::mutex sink_mutex;
+    std::atomic<uint64_t> reported(0);
+
+    AllPairsStats stats = forEachTile(matrix, pool,
+        [&](size_t a_begin, size_t a_end, size_t b_begin, size_t b_end, const float* scores) {
+            thread_local std::vector<SimilarPair> found;
+            const size_t width = b_end - b_begin;
+
+            found.clear();
+            for (size_t i = a_begin; i < a_end; ++i) {
+                const float* row = scores + (i - a_begin) * width;
+                // 对角块只取 j > i
+                size_t j_begin = a_begin == b_begin ? i + 1 : b_begin;
+                for (size_t j = j_begin; j < b_end; ++j) {
+                    if (row[j - b_begin] >= threshold) {
+                        found.push_back(SimilarPair{(uint32_t)i, (uint32_t)j, row[j - b_begin]});
+                    }
+                }
+            }
+
+            if (!found.empty()) {
+                reported += found.size();
+                std::lock_guard<std::mutex> lock(sink_mutex);
+                sink(found);
+            }
+        }, block);
+
+    stats.pairs_reported = reported;
+    return stats;
+}
@@ -0,0 +1,229 @@
+#include "frame_log.h"
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// 帧日志文件格式：
+//   [文件头，填充到一页] [帧数据，每帧起始地址按64字节对齐] [count 个 FrameLogEntry 索引]
+const char kFrameLogMagic[8] = {'S', 'F', 'R', 'F', 'L', 'O', 'G', '1'};
+const uint32_t kFrameLogVersion = 1;
+const size_t kPageSize = 4096;
+const size_t kFrameAlignment = 64;
+
+struct FrameLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t index_offset;
+};
+
+} // namespace
+
+FrameLogWriter::FrameLogWriter()
+    : encoding_(FrameEncoding::RAW), png_level_(1), position_(0), data_bytes_(0) {
+}
+
+FrameLogWriter::~FrameLogWriter() {
+    close();
+}
+
+bool FrameLogWriter::open(const std::string& path, FrameEncoding encoding, int png_level) {
+    close();
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        std::cerr << "[FrameLog] 错误：无法创建帧日志: " << path << std::endl;
+        return false;
+    }
+
+    path_ = path;
+    encoding_ = encoding;
+    png_level_ = png_level;
+    entries_.clear();
+    data_bytes_ = 0;
+
+    // 文件头在 close() 时回填，这里先占位一页
+    std::vector<char> header_page(kPageSize, 0);
+    out_.write(header_page.data(), header_page.size());
+    position_ = kPageSize;
+    return true;
+}
+
+bool FrameLogWriter::write(const cv::Mat& frame, uint64_t timestamp_us) {
+    if (!out_.is_open() || frame.empty()) {
+        return false;
+    }
+
+    FrameLogEntry entry;
+    std::memset(&entry, 0, sizeof(entry));
+    entry.timestamp_us = timestamp_us;
+    entry.width = (uint32_t)frame.cols;
+    entry.height = (uint32_t)frame.rows;
+    entry.type = frame.type();
+    entry.encoding = (uint32_t)encoding_;
+
+    // 对齐帧起始地址，RAW 帧映射后可直接作为 cv::Mat 使用
+    size_t padding = (kFrameAlignment - position_ % kFrameAlignment) % kFrameAlignment;
+    if (padding > 0) {
+        static const char zeros[kFrameAlignment] = {0};
+        out_.write(zeros, padding);
+        position_ += padding;
+    }
+    entry.offset = position_;
+
+    if (encoding_ == FrameEncoding::PNG) {
+        if (!cv::imencode(".png", frame, encoded_, {cv::IMWRITE_PNG_COMPRESSION, png_level_})) {
+            std::cerr << "[FrameLog] 错误：PNG 编码失败" << std::endl;
+            return false;
+        }
+        out_.write(reinterpret_cast<const char*>(encoded_.data()), encoded_.size());
+        entry.size = encoded_.size();
+    } else {
+        const size_t row_bytes = frame.cols * frame.elemSize();
+        for (int y = 0; y < frame.rows; ++y) {
+            out_.write(reinterpret_cast<const char*>(frame.ptr(y)), row_bytes);
+        }
+        entry.size = row_bytes * frame.rows;
+    }
+
+    if (!out_) {
+        std::cerr << "[FrameLog] 错误：写入帧日志失败: " << path_ << std::endl;
+        return false;
+    }
+    position_ += entry.size;
+    data_bytes_ += entry.size;
+    entries_.push_back(entry);
+    return true;
+}
+
+bool FrameLogWriter::close() {
+    if (!out_.is_open()) {
+        return true;
+    }
+
+    // 写入索引，然后回填文件头
+    FrameLogHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kFrameLogMagic, sizeof(header.magic));
+    header.version = kFrameLogVersion;
+    header.count = entries_.size();
+    header.index_offset = position_;
+
+    out_.write(reinterpret_cast<const char*>(entries_.data()), entries_.size() * sizeof(FrameLogEntry));
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    bool ok = (bool)out_;
+    out_.close();
+    if (!ok) {
+        std::cerr << "[FrameLog] 错误：写入帧日志索引失败: " << path_ << std::endl;
+    }
+    return ok;
+}
+
+FrameLogReader::FrameLogReader() : fd_(-1), mapping_(nullptr), mapping_size_(0) {
+}
+
+FrameLogReader::~FrameLogReader() {
+    close();
+}
+
+bool FrameLogReader::open(const std::string& path) {
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::cerr << "[FrameLog] 错误：无法打开帧日志: " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || (size_t)st.st_size < kPageSize) {
+        std::cerr << "[FrameLog] 错误：帧日志文件过小: " << path << std::endl;
+        close();
+        return false;
+    }
+    mapping_size_ = st.st_size;
+
+    void* mapped = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "[FrameLog] 错误：无法映射帧日志: " << path << std::endl;
+        mapping_size_ = 0;
+        close();
+        return false;
+    }
+    mapping_ = static_cast<uint8_t*>(mapped);
+    madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+
+    // 校验文件头与索引范围（未正常关闭的日志没有索引）
+    FrameLogHeader header;
+    std::memcpy(&header, mapping_, sizeof(header));
+    if (std::memcmp(header.magic, kFrameLogMagic, sizeof(header.magic)) != 0 ||
+        header.version != kFrameLogVersion) {
+        std::cerr << "[FrameLog] 错误：不是有效的帧日志文件: " << path << std::endl;
+        close();
+        return false;
+    }
+    if (header.index_offset < kPageSize ||
+        header.index_offset + header.count * sizeof(FrameLogEntry) > mapping_size_) {
+        std::cerr << "[FrameLog] 错误：帧日志索引损坏（录制是否正常结束？）: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    entries_.resize(header.count);
+    std::memcpy(entries_.data(), mapping_ + header.index_offset, header.count * sizeof(FrameLogEntry));
+    for (const auto& entry : entries_) {
+        if (entry.offset + entry.size > header.index_offset) {
+            std::cerr << "[FrameLog] 错误：帧数据越界: " << path << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    std::cout << "[FrameLog] 打开帧日志: " << path << " (" << entries_.size() << " 帧, "
+              << durationUs() / 1000 << " ms)" << std::endl;
+    return true;
+}
+
+void FrameLogReader::close() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+    }
+    mapping_size_ = 0;
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    entries_.clear();
+}
+
+uint64_t FrameLogReader::durationUs() const {
+    return entries_.empty() ? 0 : entries_.back().timestamp_us;
+}
+
+bool FrameLogReader::read(size_t index, cv::Mat& frame) const {
+    if (index >= entries_.size()) {
+        return false;
+    }
+    const FrameLogEntry& entry = entries_[index];
+    uint8_t* data = mapping_ + entry.offset;
+
+    if (entry.encoding == (uint32_t)FrameEncoding::RAW) {
+        frame = cv::Mat((int)entry.height, (int)entry.width, entry.type, data);
+        return entry.size == frame.total() * frame.elemSize();
+    }
+
+    frame = cv::imdecode(cv::Mat(1, (int)entry.size, CV_8U, data), cv::IMREAD_UNCHANGED);
+    if (frame.empty()) {
+        std::cerr << "[FrameLog] 错误：第 " << index << " 帧解码失败" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,601 @@
+#include "haar_cascade.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define HAAR_HAVE_AVX2 1
+#define HAAR_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define HAAR_HAVE_AVX2 0
+#endif
+
+namespace {
+
+// OpenCV 读取阶段阈值时减去的容差
+const float kStageThresholdEps = 1e-5f;
+
+// 方差归一化后低于此值的窗口视为平坦区域，不评估
+const double kMinVarianceNorm = 1e-1;
+
+// SIMD 内核一次评估的窗口数
+const int kLanes = 8;
+
+// 每个并行任务扫描的窗口行数
+const int kStripeRows = 8;
+
+// 矩形的四个角在积分图中的偏移（左上、右上、左下、右下）
+inline void rectOffsets(const cv::Rect& r, int step, int* ofs) {
+    ofs[0] = r.y * step + r.x;
+    ofs[1] = r.y * step + r.x + r.width;
+    ofs[2] = (r.y + r.height) * step + r.x;
+    ofs[3] = (r.y + r.height) * step + r.x + r.width;
+}
+
+// 积分图矩形和：按无符号运算，大图积分值溢出 int 时差值仍然正确（与 OpenCV 的 int 运算结果一致）
+inline int rectSum(const int* p, int o0, int o1, int o2, int o3) {
+    return (int)((uint32_t)p[o0] - (uint32_t)p[o1] - (uint32_t)p[o2] + (uint32_t)p[o3]);
+}
+
+} // namespace
+
+// 积分图缓冲区：各尺度的积分图按 OpenCV 的布局并排存放，共用同一行跨度，偏移表只需计算一次
+struct HaarCascade::Workspace {
+    cv::Mat sum;                    // CV_32S
+    cv::Mat sqsum;                  // CV_32S（窗口内平方和不超过 2^32，按无符号解释）
+    const HaarCascade* owner = nullptr;
+    int step = 0;                   // 偏移表对应的行跨度（元素数）
+    std::vector<int> ofs[12];       // 各 stump 三个矩形的四角偏移，下标为 矩形*4+角
+    int norm_ofs[4] = {0, 0, 0, 0}; // 归一化矩形的四角偏移
+};
+
+HaarCascade::Workspace& HaarCascade::workspace() {
+    thread_local Workspace ws;
+    return ws;
+}
+
+HaarCascade::HaarCascade() : use_simd_(simdSupported()) {
+}
+
+bool HaarCascade::simdSupported() {
+#if HAAR_HAVE_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+void HaarCascade::setUseSimd(bool use_simd) {
+    use_simd_ = use_simd && simdSupported();
+}
+
+bool HaarCascade::read(const cv::FileNode& node) {
+    stages_.clear();
+    threshold_.clear();
+    left_.clear();
+    right_.clear();
+    for (int r = 0; r < 3; ++r) {
+        weight_[r].clear();
+        rect_[r].clear();
+    }
+
+    if (node.empty() || (std::string)node["stageType"] != "BOOST" || (std::string)node["featureType"] != "HAAR") {
+        std::cerr << "[HaarCascade] 不支持的级联模型（仅支持 BOOST + HAAR）" << std::endl;
+        return false;
+    }
+    window_ = cv::Size((int)node["width"], (int)node["height"]);
+    if (window_.width < 3 || window_.height < 3) {
+        std::cerr << "[HaarCascade] 级联模型的窗口尺寸无效" << std::endl;
+        return false;
+    }
+    norm_rect_ = cv::Rect(1, 1, window_.width - 2, window_.height - 2);
+
+    // 特征表：每个特征最多三个矩形
+    struct Feature {
+        cv::Rect rect[3];
+        float weight[3] = {0.f, 0.f, 0.f};
+    };
+    std::vector<Feature> features;
+    cv::FileNode feature_nodes = node["features"];
+    for (cv::FileNodeIterator it = feature_nodes.begin(); it != feature_nodes.end(); ++it) {
+        cv::FileNode feature_node = *it;
+        if ((int)feature_node["tilted"] != 0) {
+            std::cerr << "[HaarCascade] 不支持倾斜特征" << std::endl;
+            return false;
+        }
+        cv::FileNode rects = feature_node["rects"];
+        if (rects.size() < 1 || rects.size() > 3) {
+            std::cerr << "[HaarCascade] 特征矩形数无效" << std::endl;
+            return false;
+        }
+        Feature feature;
+        int r = 0;
+        for (cv::FileNodeIterator rit = rects.begin(); rit != rects.end(); ++rit, ++r) {
+            std::vector<float> values;
+            *rit >> values;
+            if (values.size() != 5) {
+                std::cerr << "[HaarCascade] 特征矩形格式无效" << std::endl;
+                return false;
+            }
+            feature.rect[r] = cv::Rect((int)values[0], (int)values[1], (int)values[2], (int)values[3]);
+            feature.weight[r] = values[4];
+            if ((feature.rect[r] & cv::Rect(0, 0, window_.width, window_.height)) != feature.rect[r]) {
+                std::cerr << "[HaarCascade] 特征矩形超出窗口" << std::endl;
+                return false;
+            }
+        }
+        features.push_back(feature);
+    }
+
+    // 阶段与 stump：按阶段顺序展开，stump 直接携带所用特征的矩形
+    cv::FileNode stage_nodes = node["stages"];
+    for (cv::FileNodeIterator sit = stage_nodes.begin(); sit != stage_nodes.end(); ++sit) {
+        cv::FileNode stage_node = *sit;
+        Stage stage;
+        stage.first = (int)threshold_.size();
+        stage.threshold = (float)stage_node["stageThreshold"] - kStageThresholdEps;
+
+        cv::FileNode weak_nodes = stage_node["weakClassifiers"];
+        for (cv::FileNodeIterator wit = weak_nodes.begin(); wit != weak_nodes.end(); ++wit) {
+            std::vector<double> internal;
+            std::vector<double> leaves;
+            (*wit)["internalNodes"] >> internal;
+            (*wit)["leafValues"] >> leaves;
+
+            // stump：一个内部节点，左右子节点都是叶子（以 -叶下标 表示）
+            if (internal.size() != 4 || leaves.size() != 2 || internal[0] > 0 || internal[1] > 0) {
+                std::cerr << "[HaarCascade] 仅支持单节点（stump）弱分类器" << std::endl;
+                return false;
+            }
+            int feature_index = (int)internal[2];
+            if (feature_index < 0 || feature_index >= (int)features.size()) {
+                std::cerr << "[HaarCascade] 特征下标越界: " << feature_index << std::endl;
+                return false;
+            }
+            const Feature& feature = features[feature_index];
+            threshold_.push_back((float)internal[3]);
+            left_.push_back((float)leaves[(int)-internal[0]]);
+            right_.push_back((float)leaves[(int)-internal[1]]);
+            for (int r = 0; r < 3; ++r) {
+                weight_[r].push_back(feature.weight[r]);
+                rect_[r].push_back(feature.rect[r]);
+            }
+        }
+
+        stage.count = (int)threshold_.size() - stage.first;
+        if (stage.count == 0) {
+            std::cerr << "[HaarCascade] 级联阶段没有弱分类器" << std::endl;
+            stages_.clear();
+            return false;
+        }
+        stages_.push_back(stage);
+    }
+
+    if (stages_.empty()) {
+        std::cerr << "[HaarCascade] 级联模型没有阶段" << std::endl;
+        return false;
+    }
+    std::cout << "[HaarCascade] 已加载 " << stages_.size() << " 个阶段, " << threshold_.size()
+              << " 个弱分类器, 窗口 " << window_.width << "x" << window_.height
+              << (use_simd_ ? " (AVX2)" : " (标量)") << std::endl;
+    return true;
+}
+
+std::vector<HaarCascade::ScaleLayer> HaarCascade::layoutScales(const cv::Size& image_size, double scale_factor,
+                                                               cv::Size min_size, cv::Size max_size,
+                                                               cv::Size& buffer_size) const {
+    std::vector<ScaleLayer> layers;
+    if (max_size.width == 0 || max_size.height == 0) {
+        max_size = image_size;
+    }
+    if (image_size.width < window_.width || image_size.height < window_.height) {
+        return layers;
+    }
+
+    // 先算出窗口不超过图像的全部缩放比例，再按最小/最大尺寸筛选
+    std::vector<float> all_scales;
+    for (double factor = 1; ; factor *= scale_factor) {
+        cv::Size window(cvRound(window_.width * factor), cvRound(window_.height * factor));
+        if (window.width > image_size.width || window.height > image_size.height) {
+            break;
+        }
+        all_scales.push_back((float)factor);
+    }
+    std::vector<float> scales;
+    for (float scale : all_scales) {
+        cv::Size window(cvRound(window_.width * scale), cvRound(window_.height * scale));
+        if (window.width > max_size.width || window.height > max_size.height) {
+            break;
+        }
+        if (window.width < min_size.width || window.height < min_size.height) {
+            continue;
+        }
+        scales.push_back(scale);
+    }
+    if (scales.empty()) {
+        return layers;
+    }
+
+    // 各尺度积分图从左到右排列，放不下时换到下一个条带
+    buffer_size.width = (int)cv::alignSize(cvRound(image_size.width / scales[0]) + 31, 32);
+    int layer_dy = 0;
+    cv::Point layer_ofs(0, 0);
+    for (size_t i = 0; i < scales.size(); ++i) {
+        ScaleLayer layer;
+        layer.scale = scales[i];
+        layer.ystep = layer.scale >= 2 ? 1 : 2;
+        layer.size = cv::Size(cvRound(image_size.width / layer.scale), cvRound(image_size.height / layer.scale));
+        cv::Size integral_size(layer.size.width + 1, layer.size.height + 1);
+        if (i == 0) {
+            layer_dy = integral_size.height;
+        }
+        if (layer_ofs.x + integral_size.width > buffer_size.width) {
+            layer_ofs = cv::Point(0, layer_ofs.y + layer_dy);
+            layer_dy = integral_size.height;
+        }
+        layer.offset = layer_ofs.y * buffer_size.width + layer_ofs.x;
+        layer_ofs.x += integral_size.width;
+        layers.push_back(layer);
+    }
+    buffer_size.height = layer_ofs.y + layer_dy;
+    return layers;
+}
+
+void HaarCascade::computeOffsets(Workspace& ws, int step) const {
+    if (ws.owner == this && ws.step == step) {
+        return;
+    }
+    const size_t count = threshold_.size();
+    for (int k = 0; k < 12; ++k) {
+        ws.ofs[k].resize(count);
+    }
+    int corners[4];
+    for (size_t i = 0; i < count; ++i) {
+        for (int r = 0; r < 3; ++r) {
+            rectOffsets(rect_[r][i], step, corners);
+            for (int c = 0; c < 4; ++c) {
+                ws.ofs[r * 4 + c][i] = corners[c];
+            }
+        }
+    }
+    rectOffsets(norm_rect_, step, ws.norm_ofs);
+    ws.owner = this;
+    ws.step = step;
+}
+
+int HaarCascade::evaluateWindow(const Workspace& ws, const int* sum, const int* sqsum, int first_stage) const {
+    // 方差归一化因子（与 OpenCV 的 HaarEvaluator::setWindow 相同）
+    const int* n = ws.norm_ofs;
+    int valsum = rectSum(sum, n[0], n[1], n[2], n[3]);
+    unsigned valsqsum = (unsigned)rectSum(sqsum, n[0], n[1], n[2], n[3]);
+    double area = norm_rect_.area();
+    double nf = area * valsqsum - (double)valsum * valsum;
+    if (!(nf > 0.)) {
+        return -1;
+    }
+    float norm = (float)(1. / std::sqrt(nf));
+    if (!(area * norm < kMinVarianceNorm)) {
+        return -1;
+    }
+
+    // 逐阶段累加 stump 输出；特征值为整数和的小整数倍，单精度运算是精确的
+    for (size_t s = first_stage; s < stages_.size(); ++s) {
+        const Stage& stage = stages_[s];
+        double stage_sum = 0;
+        for (int i = stage.first; i < stage.first + stage.count; ++i) {
+            float value = weight_[0][i] * (float)rectSum(sum, ws.ofs[0][i], ws.ofs[1][i], ws.ofs[2][i], ws.ofs[3][i]) +
+                          weight_[1][i] * (float)rectSum(sum, ws.ofs[4][i], ws.ofs[5][i], ws.ofs[6][i], ws.ofs[7][i]);
+            if (weight_[2][i] != 0.0f) {
+                value += weight_[2][i] * (float)rectSum(sum, ws.ofs[8][i], ws.ofs[9][i], ws.ofs[10][i], ws.ofs[11][i]);
+            }
+            value *= norm;
+            stage_sum += value < threshold_[i] ? left_[i] : right_[i];
+        }
+        if (stage_sum < stage.threshold) {
+            return s == 0 ? 0 : -1;
+        }
+    }
+    return 1;
+}
+
+void HaarCascade::scanRowsScalar(const Workspace& ws, const ScaleLayer& layer, int row_begin, int row_end,
+                                 std::vector<cv::Point>& hits) const {
+    const int step = ws.step;
+    const int* sum = ws.sum.ptr<int>() + layer.offset;
+    const int* sqsum = ws.sqsum.ptr<int>() + layer.offset;
+    const int width = std::max(layer.size.width + 1 - window_.width, 0);
+
+    for (int y = row_begin; y < row_end; y += layer.ystep) {
+        for (int x = 0; x < width; x += layer.ystep) {
+            int result = evaluateWindow(ws, sum + y * step + x, sqsum + y * step + x, 0);
+            if (result > 0) {
+                hits.push_back(cv::Point(x, y));
+            }
+            // 第0阶段即被拒绝的窗口，其右侧相邻窗口也跳过
+            if (result == 0) {
+                x += layer.ystep;
+            }
+        }
+    }
+}
+
+#if HAAR_HAVE_AVX2
+
+namespace {
+
+// 读取8个相邻窗口在同一偏移处的积分值（窗口间隔 STEP 列）
+template <int STEP>
+HAAR_AVX2_TARGET inline __m256i load8(const int* p) {
+    if (STEP == 1) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    // 取两组8个值中的偶数位置：[a0 a2 b0 b2 | a4 a6 b4 b6] 再按64位重排
+    __m256 a = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    __m256 b = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8)));
+    __m256 even = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    return _mm256_permute4x64_epi64(_mm256_castps_si256(even), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+template <int STEP>
+HAAR_AVX2_TARGET inline __m256i rectSum8(const int* p, int o0, int o1, int o2, int o3) {
+    return _mm256_add_epi32(_mm256_sub_epi32(load8<STEP>(p + o0), load8<STEP>(p + o1)),
+                            _mm256_sub_epi32(load8<STEP>(p + o3), load8<STEP>(p + o2)));
+}
+
+// SIMD 内核需要的只读表
+struct KernelTables {
+    const int* const* ofs;       // 12 个偏移数组
+    const float* weight0;
+    const float* weight1;
+    const float* weight2;
+    const float* threshold;
+    const float* left;
+    const float* right;
+};
+
+// 评估8个窗口的一个阶段，返回通过的窗口位掩码
+template <int STEP>
+HAAR_AVX2_TARGET int evaluateStage8(const KernelTables& t, int first, int count, float stage_threshold,
+                                    const int* sum, __m256 norm) {
+    const int* const* ofs = t.ofs;
+    __m256d acc_lo = _mm256_setzero_pd();
+    __m256d acc_hi = _mm256_setzero_pd();
+    for (int i = first; i < first + count; ++i) {
+        __m256 value = _mm256_add_ps(
+            _mm256_mul_ps(_mm256_set1_ps(t.weight0[i]),
+                          _mm256_cvtepi32_ps(rectSum8<STEP>(sum, ofs[0][i], ofs[1][i], ofs[2][i], ofs[3][i]))),
+            _mm256_mul_ps(_mm256_set1_ps(t.weight1[i]),
+                          _mm256_cvtepi32_ps(rectSum8<STEP>(sum, ofs[4][i], ofs[5][i], ofs[6][i], ofs[7][i]))));
+        if (t.weight2[i] != 0.0f) {
+            value = _mm256_add_ps(value,
+                _mm256_mul_ps(_mm256_set1_ps(t.weight2[i]),
+                              _mm256_cvtepi32_ps(rectSum8<STEP>(sum, ofs[8][i], ofs[9][i], ofs[10][i], ofs[11][i]))));
+        }
+        value = _mm256_mul_ps(value, norm);
+        __m256 below = _mm256_cmp_ps(value, _mm256_set1_ps(t.threshold[i]), _CMP_LT_OQ);
+        __m256 leaf = _mm256_blendv_ps(_mm256_set1_ps(t.right[i]), _mm256_set1_ps(t.left[i]), below);
+        // 与 OpenCV 一样以双精度累加
+        acc_lo = _mm256_add_pd(acc_lo, _mm256_cvtps_pd(_mm256_castps256_ps128(leaf)));
+        acc_hi = _mm256_add_pd(acc_hi, _mm256_cvtps_pd(_mm256_extractf128_ps(leaf, 1)));
+    }
+    __m256d limit = _mm256_set1_pd(stage_threshold);
+    int pass_lo = _mm256_movemask_pd(_mm256_cmp_pd(acc_lo, limit, _CMP_NLT_UQ));
+    int pass_hi = _mm256_movemask_pd(_mm256_cmp_pd(acc_hi, limit, _CMP_NLT_UQ));
+    return pass_lo | (pass_hi << 4);
+}
+
+// 8个窗口的方差归一化因子，返回有效窗口的位掩码
+template <int STEP>
+HAAR_AVX2_TARGET int normalize8(const int* sum, const int* sqsum, const int* n, double area, __m256& norm) {
+    __m256i valsum = rectSum8<STEP>(sum, n[0], n[1], n[2], n[3]);
+    __m256i valsqsum = rectSum8<STEP>(sqsum, n[0], n[1], n[2], n[3]);
+    __m256d area4 = _mm256_set1_pd(area);
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d limit = _mm256_set1_pd(kMinVarianceNorm);
+
+    __m128 halves[2];
+    int valid = 0;
+    for (int h = 0; h < 2; ++h) {
+        __m128i s = h == 0 ? _mm256_castsi256_si128(valsum) : _mm256_extracti128_si256(valsum, 1);
+        __m128i q = h == 0 ? _mm256_castsi256_si128(valsqsum) : _mm256_extracti128_si256(valsqsum, 1);
+        __m256d sd = _mm256_cvtepi32_pd(s);
+        __m256d nf = _mm256_sub_pd(_mm256_mul_pd(area4, _mm256_cvtepi32_pd(q)), _mm256_mul_pd(sd, sd));
+        __m256d positive = _mm256_cmp_pd(nf, _mm256_setzero_pd(), _CMP_GT_OQ);
+        halves[h] = _mm256_cvtpd_ps(_mm256_div_pd(one, _mm256_sqrt_pd(nf)));
+        __m256d textured = _mm256_cmp_pd(_mm256_mul_pd(area4, _mm256_cvtps_pd(halves[h])), limit, _CMP_LT_OQ);
+        valid |= _mm256_movemask_pd(_mm256_and_pd(positive, textured)) << (4 * h);
+    }
+    norm = _mm256_set_m128(halves[1], halves[0]);
+    return valid;
+}
+
+} // namespace
+
+template <int STEP, typename FinishScalar>
+HAAR_AVX2_TARGET static void scanRowsAvx2(const KernelTables& tables, const int* stage_first, const int* stage_count,
+                                          const float* stage_threshold, int stage_count_total,
+                                          const int* sum, const int* sqsum, int step, const int* norm_ofs,
+                                          double area, int width, int row_begin, int row_end,
+                                          std::vector<cv::Point>& hits,
+                                          const FinishScalar& finish_scalar) {
+    const int block = kLanes * STEP;
+    for (int y = row_begin; y < row_end; y += STEP) {
+        const int* row_sum = sum + y * step;
+        const int* row_sqsum = sqsum + y * step;
+        bool skip_next = false;
+        for (int x0 = 0; x0 < width; x0 += block) {
+            const int lanes = std::min(kLanes, (width - x0 + STEP - 1) / STEP);
+            __m256 norm;
+            int valid = normalize8<STEP>(row_sum + x0, row_sqsum + x0, norm_ofs, area, norm) & ((1 << lanes) - 1);
+
+            int pass0 = 0;
+            if (valid) {
+                pass0 = valid & evaluateStage8<STEP>(tables, stage_first[0], stage_count[0], stage_threshold[0],
+                                                     row_sum + x0, norm);
+            }
+
+            // 按 OpenCV 的扫描顺序确定实际评估的窗口：第0阶段拒绝的窗口跳过其右侧相邻窗口
+            int active = 0;
+            for (int k = 0; k < lanes; ++k) {
+                if (skip_next) {
+                    skip_next = false;
+                    continue;
+                }
+                if (valid & (1 << k)) {
+                    if (pass0 & (1 << k)) {
+                        active |= 1 << k;
+                    } else {
+                        skip_next = true;
+                    }
+                }
+            }
+
+            for (int s = 1; s < stage_count_total && active; ++s) {
+                // 只剩一个窗口时改用标量评估剩余阶段
+                if ((active & (active - 1)) == 0) {
+                    int k = __builtin_ctz(active);
+                    if (!finish_scalar(x0 + k * STEP, y, s)) {
+                        active = 0;
+                    }
+                    break;
+                }
+                active &= evaluateStage8<STEP>(tables, stage_first[s], stage_count[s], stage_threshold[s],
+                                               row_sum + x0, norm);
+            }
+            while (active) {
+                int k = __builtin_ctz(active);
+                hits.push_back(cv::Point(x0 + k * STEP, y));
+                active &= active - 1;
+            }
+        }
+    }
+}
+
+#endif
+
+void HaarCascade::scanRowsSimd(const Workspace& ws, const ScaleLayer& layer, int row_begin, int row_end,
+                               std::vector<cv::Point>& hits) const {
+#if HAAR_HAVE_AVX2
+    const int* ofs[12];
+    for (int k = 0; k < 12; ++k) {
+        ofs[k] = ws.ofs[k].data();
+    }
+    KernelTables tables = {ofs, weight_[0].data(), weight_[1].data(), weight_[2].data(),
+                           threshold_.data(), left_.data(), right_.data()};
+    std::vector<int> stage_first(stages_.size());
+    std::vector<int> stage_count(stages_.size());
+    std::vector<float> stage_threshold(stages_.size());
+    for (size_t s = 0; s < stages_.size(); ++s) {
+        stage_first[s] = stages_[s].first;
+        stage_count[s] = stages_[s].count;
+        stage_threshold[s] = stages_[s].threshold;
+    }
+
+    const int step = ws.step;
+    const int* sum = ws.sum.ptr<int>() + layer.offset;
+    const int* sqsum = ws.sqsum.ptr<int>() + layer.offset;
+    const int width = std::max(layer.size.width + 1 - window_.width, 0);
+    auto finish_scalar = [&](int x, int y, int first_stage) {
+        return evaluateWindow(ws, sum + y * step + x, sqsum + y * step + x, first_stage) > 0;
+    };
+
+    if (layer.ystep == 1) {
+        scanRowsAvx2<1>(tables, stage_first.data(), stage_count.data(), stage_threshold.data(), (int)stages_.size(),
+                        sum, sqsum, step, ws.norm_ofs, norm_rect_.area(), width, row_begin, row_end, hits,
+                        finish_scalar);
+    } else {
+        scanRowsAvx2<2>(tables, stage_first.data(), stage_count.data(), stage_threshold.data(), (int)stages_.size(),
+                        sum, sqsum, step, ws.norm_ofs, norm_rect_.area(), width, row_begin, row_end, hits,
+                        finish_scalar);
+    }
+#else
+    scanRowsScalar(ws, layer, row_begin, row_end, hits);
+#endif
+}
+
+void HaarCascade::detectCandidates(const cv::Mat& gray, std::vector<cv::Rect>& candidates,
+                                   double scale_factor, cv::Size min_size, cv::Size max_size) const {
+    candidates.clear();
+    if (empty() || gray.empty()) {
+        return;
+    }
+    if (gray.type() != CV_8UC1 || scale_factor <= 1.0) {
+        std::cerr << "[HaarCascade] 错误：输入须为 CV_8UC1 灰度图，缩放因子须大于1" << std::endl;
+        return;
+    }
+
+    cv::Size buffer_size;
+    std::vector<ScaleLayer> layers = layoutScales(gray.size(), scale_factor, min_size, max_size, buffer_size);
+    if (layers.empty()) {
+        return;
+    }
+
+    // 1) 各尺度缩小并计算积分图（多留一行，SIMD 读取末尾窗口时不越界）
+    Workspace& ws = workspace();
+    ws.sum.create(buffer_size.height + 1, buffer_size.width, CV_32S);
+    ws.sqsum.create(buffer_size.height + 1, buffer_size.width, CV_32S);
+    const int step = (int)(ws.sum.step / sizeof(int));
+    computeOffsets(ws, step);
+
+    cv::parallel_for_(cv::Range(0, (int)layers.size()), [&](const cv::Range& range) {
+        thread_local cv::Mat resized;
+        for (int i = range.start; i < range.end; ++i) {
+            const ScaleLayer& layer = layers[i];
+            cv::Size integral_size(layer.size.width + 1, layer.size.height + 1);
+            cv::Mat sum(integral_size, CV_32S, ws.sum.ptr<int>() + layer.offset, ws.sum.step);
+            cv::Mat sqsum(integral_size, CV_32S, ws.sqsum.ptr<int>() + layer.offset, ws.sqsum.step);
+            resized.create(layer.size, CV_8U);
+            cv::resize(gray, resized, layer.size, 1. / layer.scale, 1. / layer.scale, cv::INTER_LINEAR_EXACT);
+            cv::integral(resized, sum, sqsum, CV_32S, CV_32S);
+        }
+    });
+
+    // 2) 按（尺度，行条带）划分任务并行扫描
+    struct Task {
+        int layer;
+        int row_begin;
+        int row_end;
+    };
+    std::vector<Task> tasks;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const ScaleLayer& layer = layers[i];
+        int rows = std::max(layer.size.height + 1 - window_.height, 0);
+        int stripe = kStripeRows * layer.ystep;
+        for (int row = 0; row < rows; row += stripe) {
+            tasks.push_back({(int)i, row, std::min(rows, row + stripe)});
+        }
+    }
+
+    std::vector<std::vector<cv::Point>> hits(tasks.size());
+    cv::parallel_for_(cv::Range(0, (int)tasks.size()), [&](const cv::Range& range) {
+        for (int t = range.start; t < range.end; ++t) {
+            const Task& task = tasks[t];
+            if (use_simd_) {
+                scanRowsSimd(ws, layers[task.layer], task.row_begin, task.row_end, hits[t]);
+            } else {
+                scanRowsScalar(ws, layers[task.layer], task.row_begin, task.row_end, hits[t]);
+            }
+        }
+    });
+
+    // 3) 映射回原图坐标（与 OpenCV 相同，不裁剪到图像范围：取整后的窗口可能略超出边界）
+    for (size_t t = 0; t < tasks.size(); ++t) {
+        const ScaleLayer& layer = layers[tasks[t].layer];
+        cv::Size window(cvRound(window_.width * layer.scale), cvRound(window_.height * layer.scale));
+        for (const cv::Point& hit : hits[t]) {
+            candidates.push_back(cv::Rect(cvRound(hit.x * layer.scale), cvRound(hit.y * layer.scale),
+                                          window.width, window.height));
+        }
+    }
+}
+
+void HaarCascade::detectMultiScale(const cv::Mat& gray, std::vector<cv::Rect>& objects,
+                                   double scale_factor, int min_neighbors,
+                                   cv::Size min_size, cv::Size max_size) const {
+    detectCandidates(gray, objects, scale_factor, min_size, max_size);
+    // 与 OpenCV 相同的分组（eps = 0.2），min_neighbors <= 0 时保留全部候选
+    cv::groupRectangles(objects, min_neighbors, 0.2);
+}
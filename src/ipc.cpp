@@ -0,0 +1,243 @@
+#include "ipc.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ipc {
+
+namespace {
+
+bool fillAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[IPC] 错误：套接字路径过长: " << path << std::endl;
+        return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return true;
+}
+
+} // namespace
+
+int listenUnix(const std::string& path, int backlog) {
+    sockaddr_un addr;
+    if (!fillAddress(path, addr)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ::unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(fd, backlog) != 0) {
+        std::cerr << "[IPC] 错误：无法监听 " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectUnix(const std::string& path) {
+    sockaddr_un addr;
+    if (!fillAddress(path, addr)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void closeSocket(int fd) {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        // MSG_NOSIGNAL：对端关闭时返回错误而不是触发 SIGPIPE
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool readAll(int fd, void* data, size_t size, int timeout_ms) {
+    using clock = std::chrono::steady_clock;
+    auto deadline = clock::now() + std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        if (timeout_ms >= 0) {
+            int remaining = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - clock::now()).count();
+            if (remaining < 0) {
+                return false;
+            }
+            pollfd pfd = {fd, POLLIN, 0};
+            int ready = poll(&pfd, 1, remaining);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0) {
+                return false;
+            }
+        }
+
+        ssize_t n = recv(fd, p, size, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            return false; // 对端关闭
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool sendMessage(int fd, const std::vector<uint8_t>& payload) {
+    uint32_t length = (uint32_t)payload.size();
+    return writeAll(fd, &length, sizeof(length)) &&
+           writeAll(fd, payload.data(), payload.size());
+}
+
+bool recvMessage(int fd, std::vector<uint8_t>& payload, int timeout_ms, size_t max_size) {
+    uint32_t length = 0;
+    if (!readAll(fd, &length, sizeof(length), timeout_ms)) {
+        return false;
+    }
+    if (length > max_size) {
+        std::cerr << "[IPC] 错误：消息过大: " << length << " 字节" << std::endl;
+        return false;
+    }
+    payload.resize(length);
+    return length == 0 || readAll(fd, payload.data(), length, timeout_ms);
+}
+
+void Writer::putU8(uint8_t value) {
+    buffer_.push_back(value);
+}
+
+void Writer::putU32(uint32_t value) {
+    putBytes(&value, sizeof(value));
+}
+
+void Writer::putF32(float value) {
+    putBytes(&value, sizeof(value));
+}
+
+void Writer::putF64(double value) {
+    putBytes(&value, sizeof(value));
+}
+
+void Writer::putI32(int32_t value) {
+    putBytes(&value, sizeof(value));
+}
+
+void Writer::putBytes(const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    buffer_.insert(buffer_.end(), p, p + size);
+}
+
+void Writer::putString(const std::string& value) {
+    putU32((uint32_t)value.size());
+    putBytes(value.data(), value.size());
+}
+
+Reader::Reader(const uint8_t* data, size_t size)
+    : data_(data), size_(size), pos_(0), ok_(true) {
+}
+
+Reader::Reader(const std::vector<uint8_t>& payload)
+    : Reader(payload.data(), payload.size()) {
+}
+
+uint8_t Reader::getU8() {
+    uint8_t value = 0;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+uint32_t Reader::getU32() {
+    uint32_t value = 0;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+float Reader::getF32() {
+    float value = 0.0f;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+double Reader::getF64() {
+    double value = 0.0;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+int32_t Reader::getI32() {
+    int32_t value = 0;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+bool Reader::getBytes(void* out, size_t size) {
+    const uint8_t* p = skipBytes(size);
+    if (!p) {
+        return false;
+    }
+    std::memcpy(out, p, size);
+    return true;
+}
+
+const uint8_t* Reader::skipBytes(size_t size) {
+    if (!ok_ || size > size_ - pos_) {
+        ok_ = false;
+        return nullptr;
+    }
+    const uint8_t* p = data_ + pos_;
+    pos_ += size;
+    return p;
+}
+
+std::string Reader::getString() {
+    uint32_t length = getU32();
+    const uint8_t* p = skipBytes(length);
+    if (!p) {
+        return std::string();
+    }
+    return std::string(reinterpret_cast<const char*>(p), length);
+}
+
+} // namespace ipc
@@ -0,0 +1,48 @@
+#include "label_table.h"
+#include <mutex>
+
+LabelTable::LabelTable() {
+    // kUnknownLabel 保留给未匹配的结果，不进入名称索引：图库中名为 "Unknown" 的人会得到自己的ID
+    names_.push_back("Unknown");
+}
+
+LabelTable& LabelTable::global() {
+    static LabelTable table;
+    return table;
+}
+
+uint32_t LabelTable::intern(const std::string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(name);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    uint32_t id = (uint32_t)names_.size();
+    names_.push_back(name);
+    ids_.emplace(name, id);
+    return id;
+}
+
+uint32_t LabelTable::find(const std::string& name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(name);
+    return it != ids_.end() ? it->second : kUnknownLabel;
+}
+
+const std::string& LabelTable::name(uint32_t id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return id < names_.size() ? names_[id] : names_[kUnknownLabel];
+}
+
+size_t LabelTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return names_.size();
+}
@@ -0,0 +1,162 @@
+#include "latency_scheduler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// 指数平均系数
+const double kEwmaAlpha = 0.2;
+
+QualityLevel makeLevel(double scale_factor, int min_neighbors, int min_size,
+                       double input_scale, int detect_interval) {
+    QualityLevel level;
+    level.params.scale_factor = scale_factor;
+    level.params.min_neighbors = min_neighbors;
+    level.params.min_size = cv::Size(min_size, min_size);
+    level.params.input_scale = input_scale;
+    level.detect_interval = detect_interval;
+    return level;
+}
+
+inline double ewma(double current, double sample, bool first) {
+    return first ? sample : current + kEwmaAlpha * (sample - current);
+}
+
+} // namespace
+
+LatencyScheduler::LatencyScheduler()
+    : budget_ms_(0.0), level_(0),
+      upgrade_ratio_(0.6), degrade_after_(3), upgrade_after_(30),
+      over_count_(0), under_count_(0), frames_at_level_(0), cost_expiry_frames_(300),
+      frames_since_detect_(0),
+      has_last_frame_(false) {
+    // 等级 0 与默认检测参数一致，逐级提高缩放因子、最小人脸尺寸，缩小输入并降低检测频率
+    levels_.push_back(makeLevel(1.10, 3, 30, 1.00, 1));
+    levels_.push_back(makeLevel(1.15, 3, 40, 1.00, 1));
+    levels_.push_back(makeLevel(1.20, 3, 48, 0.75, 1));
+    levels_.push_back(makeLevel(1.25, 3, 60, 0.50, 2));
+    levels_.push_back(makeLevel(1.30, 2, 80, 0.50, 3));
+    levels_.push_back(makeLevel(1.40, 2, 96, 0.40, 4));
+
+    stats_.level_count = (int)levels_.size();
+    level_cost_.assign(levels_.size(), 0.0);
+    level_cost_frame_.assign(levels_.size(), 0);
+}
+
+void LatencyScheduler::setBudgetMs(double budget_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ms_ = std::max(0.0, budget_ms);
+    stats_.budget_ms = budget_ms_;
+    over_count_ = 0;
+    under_count_ = 0;
+    if (budget_ms_ <= 0.0) {
+        level_ = 0;
+        stats_.level = 0;
+    }
+}
+
+bool LatencyScheduler::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return budget_ms_ > 0.0;
+}
+
+void LatencyScheduler::beginFrame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 统计实际帧率（相邻两帧开始时间的间隔）
+    auto now = std::chrono::steady_clock::now();
+    if (has_last_frame_) {
+        double interval_ms = std::chrono::duration<double, std::milli>(now - last_frame_time_).count();
+        if (interval_ms > 0.0) {
+            stats_.achieved_fps = ewma(stats_.achieved_fps, 1000.0 / interval_ms, stats_.frames <= 1);
+        }
+    }
+    last_frame_time_ = now;
+    has_last_frame_ = true;
+    stats_.frames++;
+}
+
+bool LatencyScheduler::shouldDetect(DetectionParams& params, std::vector<cv::Rect>& reused_faces) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const QualityLevel& level = levels_[level_];
+    if (frames_since_detect_ > 0 && frames_since_detect_ < level.detect_interval) {
+        frames_since_detect_++;
+        stats_.detections_skipped++;
+        reused_faces = last_faces_;
+        return false;
+    }
+
+    frames_since_detect_ = 1;
+    params = level.params;
+    return true;
+}
+
+void LatencyScheduler::recordDetection(double detect_ms, const std::vector<cv::Rect>& faces) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.avg_detect_ms = ewma(stats_.avg_detect_ms, detect_ms, stats_.detections == 0);
+    stats_.detections++;
+    last_faces_ = faces;
+}
+
+void LatencyScheduler::endFrame(double frame_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool first = stats_.avg_frame_ms == 0.0;
+    stats_.avg_frame_ms = ewma(stats_.avg_frame_ms, frame_ms, first);
+
+    if (budget_ms_ <= 0.0) {
+        return;
+    }
+
+    // 平均值收敛后记录当前等级的实测耗时
+    frames_at_level_++;
+    if (frames_at_level_ >= degrade_after_) {
+        level_cost_[level_] = stats_.avg_frame_ms;
+        level_cost_frame_[level_] = stats_.frames;
+    }
+
+    // 滞回：超预算连续 degrade_after_ 帧降级；低于 upgrade_ratio_ × 预算连续 upgrade_after_ 帧升级
+    if (stats_.avg_frame_ms > budget_ms_) {
+        over_count_++;
+        under_count_ = 0;
+        if (over_count_ >= degrade_after_ && level_ + 1 < (int)levels_.size()) {
+            changeLevel(level_ + 1);
+        }
+    } else if (stats_.avg_frame_ms < budget_ms_ * upgrade_ratio_) {
+        under_count_++;
+        over_count_ = 0;
+        if (under_count_ >= upgrade_after_ && level_ > 0) {
+            // 上一级的实测耗时仍然有效且超出预算时不升级，避免在两级之间振荡
+            int target = level_ - 1;
+            bool known = level_cost_[target] > 0.0 &&
+                         stats_.frames - level_cost_frame_[target] < cost_expiry_frames_;
+            if (!known || level_cost_[target] <= budget_ms_) {
+                changeLevel(target);
+            } else {
+                under_count_ = 0;
+            }
+        }
+    } else {
+        over_count_ = 0;
+        under_count_ = 0;
+    }
+}
+
+SchedulerStats LatencyScheduler::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void LatencyScheduler::changeLevel(int level) {
+    std::cout << "[LatencyScheduler] 质量等级 " << level_ << " -> " << level
+              << " (平均帧耗时: " << stats_.avg_frame_ms << " ms, 预算: " << budget_ms_ << " ms)" << std::endl;
+    level_ = level;
+    stats_.level = level;
+    stats_.level_changes++;
+    over_count_ = 0;
+    under_count_ = 0;
+    frames_at_level_ = 0;
+    // 等级切换后立即按新参数检测，并让平均值重新收敛
+    frames_since_detect_ = 0;
+    stats_.avg_frame_ms = 0.0;
+}
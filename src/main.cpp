@@ -1,82 +1,458 @@
 #include <opencv2/opencv.hpp>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 
+#include "face_detection.h"
 #include "face_manager.h"
 #include "recognition_engine.h"
 #include "face_recognition.h"  // 添加这个来获取load_model函数
 #include "utils.h"  // 添加utils头文件
+#include "tiered_gallery.h"
+#include "shard_service.h"
+#include "recognition_server.h"
+#include "trace.h"
 
 using namespace cv;
 using namespace std;
 
-int main()
+// 服务模式下收到 SIGINT/SIGTERM 时退出
+static volatile std::sig_atomic_t g_stopRequested = 0;
+
+static void handleStopSignal(int) {
+    g_stopRequested = 1;
+}
+
+int main(int argc, char** argv)
 {
+    // 启动计时起点：用于统计各初始化阶段与首帧识别耗时
+    auto startupBegin = std::chrono::steady_clock::now();
+    auto sinceStartupMs = [&startupBegin]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+    };
+    
     cout << "=== 人脸识别系统 ===" << endl;
     
-    // 1) 初始化人脸识别模型
-    if (!load_model()) {
-        cerr << "错误：无法加载人脸识别模型" << endl;
-        return -1;
+    // 命令行参数：
+    //   --gallery-file <path>     使用分层图库（文件不存在时由pictures目录生成）
+    //   --gallery-budget-mb <n>   分层图库内存预算（MB，默认64）
+    //   --gallery-hot-accept <s>  热层直接接受的相似度（默认0.95），达到后跳过冷层扫描；大于1表示总是扫描冷层
+    //   --shards <n>              将图库划分到n个工作进程并行匹配
+    //   --shard-timeout-ms <n>    分片查询超时（毫秒，默认200）
+    //   --server <socket>         以服务模式运行，在本地套接字上提供识别服务
+    //   --max-batch <n>           服务模式每批最多请求数（默认8）
+    //   --max-wait-ms <n>         服务模式批次最长等待时间（毫秒，默认5）
+    //   --async-workers <n>       异步识别：采集线程不等待识别，显示最近一次完成的结果
+    //   --budget-ms <n>           每帧延迟预算（毫秒），自动降低检测质量以保持帧率
+    //   --motion-gate             启用运动门控：画面静止时跳过人脸检测
+    //   --motion-ratio <r>        运动门控的变化像素比例阈值（默认0.005）
+    //   --motion-force <n>        运动门控强制检测间隔（帧，默认30）
+    //   --threads <n>             引擎线程预算（引擎线程池与OpenCV内部线程共用）
+    //   --affinity <mode>         引擎线程池CPU绑定：none / core / numa
+    //   --detect-policy <p>       检测阶段并行方式：serial / opencv
+    //   --extract-policy <p>      特征提取阶段并行方式：serial / opencv / face
+    //   --trace <path>            记录各阶段耗时，导出为 Chrome trace-event JSON
+    //   --trace-frames <n>        追踪的帧数（默认300），达到后导出并停止追踪
+    //   --fast-startup            并发解析级联模型、加载图库、打开摄像头，缩短重启后无监控的时间
+    //   --cascade <impl>          人脸检测的级联实现：opencv（默认）/ flat（扁平化级联 + AVX2，需显式启用）
+    std::string galleryFile;
+    size_t galleryBudgetMb = 64;
+    double galleryHotAccept = 0.95;
+    int shardCount = 0;
+    int shardTimeoutMs = 200;
+    bool serverMode = false;
+    ServerConfig serverConfig;
+    size_t asyncWorkers = 0;
+    double budgetMs = 0.0;
+    MotionGateOptions motionGateOptions;
+    ParallelOptions parallelOptions;
+    bool parallelConfigured = false;
+    std::string tracePath;
+    int traceFrames = 300;
+    bool fastStartup = false;
+    auto parsePolicy = [](const std::string& name, ParallelPolicy& policy) {
+        if (name == "serial") policy = ParallelPolicy::SERIAL;
+        else if (name == "opencv") policy = ParallelPolicy::INTRA_OPENCV;
+        else if (name == "face") policy = ParallelPolicy::INTER_FACE;
+        else return false;
+        return true;
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--gallery-file" && i + 1 < argc) {
+            galleryFile = argv[++i];
+        } else if (arg == "--gallery-budget-mb" && i + 1 < argc) {
+            galleryBudgetMb = std::stoul(argv[++i]);
+        } else if (arg == "--gallery-hot-accept" && i + 1 < argc) {
+            galleryHotAccept = std::stod(argv[++i]);
+        } else if (arg == "--shards" && i + 1 < argc) {
+            shardCount = std::stoi(argv[++i]);
+        } else if (arg == "--shard-timeout-ms" && i + 1 < argc) {
+            shardTimeoutMs = std::stoi(argv[++i]);
+        } else if (arg == "--server" && i + 1 < argc) {
+            serverMode = true;
+            serverConfig.socket_path = argv[++i];
+        } else if (arg == "--max-batch" && i + 1 < argc) {
+            serverConfig.max_batch_size = std::stoul(argv[++i]);
+        } else if (arg == "--max-wait-ms" && i + 1 < argc) {
+            serverConfig.max_wait_ms = std::stoi(argv[++i]);
+        } else if (arg == "--async-workers" && i + 1 < argc) {
+            asyncWorkers = std::stoul(argv[++i]);
+        } else if (arg == "--budget-ms" && i + 1 < argc) {
+            budgetMs = std::stod(argv[++i]);
+        } else if (arg == "--motion-gate") {
+            motionGateOptions.enabled = true;
+        } else if (arg == "--motion-ratio" && i + 1 < argc) {
+            motionGateOptions.motion_ratio = std::stod(argv[++i]);
+        } else if (arg == "--motion-force" && i + 1 < argc) {
+            motionGateOptions.force_interval = std::stoi(argv[++i]);
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--trace-frames" && i + 1 < argc) {
+            traceFrames = std::stoi(argv[++i]);
+        } else if (arg == "--fast-startup") {
+            fastStartup = true;
+        } else if (arg == "--cascade" && i + 1 < argc) {
+            std::string impl = argv[++i];
+            if (impl == "flat") setCascadeBackend(CascadeBackend::FLAT);
+            else if (impl == "opencv") setCascadeBackend(CascadeBackend::OPENCV);
+            else {
+                cerr << "未知的级联实现: " << impl << endl;
+                return -1;
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            parallelOptions.threads = std::stoul(argv[++i]);
+            parallelConfigured = true;
+        } else if (arg == "--affinity" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "none") parallelOptions.affinity = AffinityMode::NONE;
+            else if (mode == "core") parallelOptions.affinity = AffinityMode::CORE;
+            else if (mode == "numa") parallelOptions.affinity = AffinityMode::NUMA;
+            else {
+                cerr << "未知的绑定方式: " << mode << endl;
+                return -1;
+            }
+            parallelConfigured = true;
+        } else if ((arg == "--detect-policy" || arg == "--extract-policy") && i + 1 < argc) {
+            ParallelPolicy& policy = arg == "--detect-policy" ? parallelOptions.detection : parallelOptions.extraction;
+            if (!parsePolicy(argv[++i], policy)) {
+                cerr << "未知的并行方式: " << argv[i] << endl;
+                return -1;
+            }
+            parallelConfigured = true;
+        } else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
     }
-    cout << "✓ 模型加载成功！" << endl;
-
-    // 2) 初始化人脸管理器 - 使用相对路径
+    
+    // 1) 初始化人脸识别模型和人脸管理器，扫描注册pictures目录中的人脸（分层图库文件已存在时跳过）
     FaceManager faceManager;
-    std::string picturesDir = ::utils::getPicturesDirectory();
-    if (!faceManager.initialize(picturesDir)) {
-        cerr << "错误：无法初始化人脸管理器" << endl;
-        return -1;
+    TieredGallery tieredGallery;
+    bool useTieredGallery = !galleryFile.empty();
+    auto loadGallery = [&]() -> bool {
+        if (!load_model()) {
+            cerr << "错误：无法加载人脸识别模型" << endl;
+            return false;
+        }
+        cout << "✓ 模型加载成功！" << endl;
+        
+        std::string picturesDir = ::utils::getPicturesDirectory();
+        if (!faceManager.initialize(picturesDir)) {
+            cerr << "错误：无法初始化人脸管理器" << endl;
+            return false;
+        }
+        
+        if (!useTieredGallery || !::utils::fileExists(galleryFile)) {
+            if (!faceManager.autoScanAndRegister()) {
+                cerr << "错误：自动扫描pictures目录失败！" << endl;
+                return false;
+            }
+            cout << "[Main] 成功注册了 " << faceManager.getRegisteredCount() << " 个人脸, "
+                 << faceManager.getIdentityCount() << " 个身份" << endl;
+            
+            if (useTieredGallery && !faceManager.exportGallery(galleryFile)) {
+                cerr << "错误：无法生成分层图库文件" << endl;
+                return false;
+            }
+        }
+        
+        if (useTieredGallery) {
+            if (!tieredGallery.open(galleryFile, galleryBudgetMb * 1024 * 1024)) {
+                cerr << "错误：无法打开分层图库" << endl;
+                return false;
+            }
+            tieredGallery.setHotAcceptSimilarity(galleryHotAccept);
+            cout << "[Main] 使用分层图库，共 " << tieredGallery.size() << " 个身份" << endl;
+        }
+        return true;
+    };
+    
+    // 2) 初始化识别引擎
+    RecognitionEngine recognitionEngine;
+    auto initEngine = [&]() -> bool {
+        if (!recognitionEngine.initialize()) {
+            cerr << "错误：无法初始化识别引擎" << endl;
+            return false;
+        }
+        recognitionEngine.setLatencyBudget(budgetMs);
+        recognitionEngine.setMotionGate(motionGateOptions);
+        return true;
+    };
+    
+    // 3) 打开摄像头（服务模式不需要）
+    VideoCapture cap;
+    auto openCamera = [&]() -> bool {
+        if (!cap.open(0) || !cap.isOpened()) {
+            cerr << "错误：无法打开摄像头！" << endl;
+            return false;
+        }
+        return true;
+    };
+    
+    // 记录每个启动阶段的耗时
+    double galleryMs = 0.0, cascadeMs = 0.0, cameraMs = 0.0;
+    auto timed = [](double& ms, const std::function<bool()>& task) {
+        auto begin = std::chrono::steady_clock::now();
+        bool ok = task();
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        return ok;
+    };
+    
+    if (fastStartup) {
+        // 级联模型解析、图库加载、摄像头打开互不依赖，并发进行；图库扫描先用到检测器时会等待模型解析完成
+        auto cascadeReady = std::async(std::launch::async, [&] { return timed(cascadeMs, preloadFaceCascade); });
+        auto galleryReady = std::async(std::launch::async, [&] { return timed(galleryMs, loadGallery); });
+        std::future<bool> cameraReady;
+        if (!serverMode) {
+            cameraReady = std::async(std::launch::async, [&] { return timed(cameraMs, openCamera); });
+        }
+        
+        bool ok = initEngine();
+        ok = cascadeReady.get() && ok;
+        ok = galleryReady.get() && ok;
+        if (cameraReady.valid()) {
+            ok = cameraReady.get() && ok;
+        }
+        if (!ok) {
+            return -1;
+        }
+    } else {
+        if (!timed(galleryMs, loadGallery) || !initEngine()) {
+            return -1;
+        }
     }
     
-    // 3) 自动扫描并注册pictures目录中的人脸
-    if (!faceManager.autoScanAndRegister()) {
-        cerr << "错误：自动扫描pictures目录失败！" << endl;
+    // 分片模式：图库划分到多个工作进程
+    // 在创建引擎线程池之前 fork，工作进程不继承这些线程
+    ShardCoordinator shardCoordinator;
+    bool useShards = shardCount > 0 && !useTieredGallery;
+    if (useShards) {
+        shardCoordinator.setTimeoutMs(shardTimeoutMs);
+        if (!shardCoordinator.start(faceManager.getKnownFeatures(), faceManager.getKnownLabels(), shardCount)) {
+            cerr << "错误：无法启动分片图库" << endl;
+            return -1;
+        }
+    }
+    
+    // 线程预算在启动任务全部结束后才应用：cv::setNumThreads 不能与正在运行的 parallel_for_
+    // （快速启动时图库扫描中的检测与特征提取）并发调用
+    // 服务模式总是创建引擎线程池（未指定时使用默认配置），批次中的人脸按人脸并行提取特征
+    if (parallelConfigured || serverMode) {
+        recognitionEngine.configureParallel(parallelOptions);
+    }
+    
+    // 服务模式：不打开摄像头，持续运行直到收到停止信号；匹配使用与实时识别相同的图库来源
+    if (serverMode) {
+        std::unique_ptr<RecognitionServer> serverPtr;
+        if (useTieredGallery) {
+            serverPtr.reset(new RecognitionServer(recognitionEngine, tieredGallery));
+        } else if (useShards) {
+            serverPtr.reset(new RecognitionServer(recognitionEngine, shardCoordinator));
+        } else {
+            serverPtr.reset(new RecognitionServer(recognitionEngine, faceManager.getIdentities()));
+        }
+        RecognitionServer& server = *serverPtr;
+        if (!server.start(serverConfig)) {
+            cerr << "错误：无法启动识别服务" << endl;
+            return -1;
+        }
+        
+        cout << "[Startup] 服务就绪: " << std::fixed << std::setprecision(1) << sinceStartupMs()
+             << " ms (图库 " << galleryMs << " ms)" << endl;
+        
+        std::signal(SIGINT, handleStopSignal);
+        std::signal(SIGTERM, handleStopSignal);
+        
+        auto lastReport = std::chrono::steady_clock::now();
+        while (!g_stopRequested) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (std::chrono::steady_clock::now() - lastReport >= std::chrono::seconds(10)) {
+                server.printStats();
+                lastReport = std::chrono::steady_clock::now();
+            }
+        }
+        
+        server.printStats();
+        server.stop();
+        return 0;
+    }
+
+    if (!fastStartup && !timed(cameraMs, openCamera)) {
         return -1;
     }
+    cout << "[Startup] " << (fastStartup ? "并发" : "顺序") << "启动完成: " << std::fixed << std::setprecision(1)
+         << sinceStartupMs() << " ms (图库 " << galleryMs << " ms, 级联模型 " << cascadeMs
+         << " ms, 摄像头 " << cameraMs << " ms)" << endl;
     
-    cout << "[Main] 成功注册了 " << faceManager.getRegisteredCount() << " 个人脸" << endl;
     cout << "[Main] 开始实时人脸识别..." << endl;
     cout << "[Main] 按ESC键退出程序" << endl;
-
-    // 4) 初始化识别引擎
-    RecognitionEngine recognitionEngine;
-    if (!recognitionEngine.initialize()) {
-        cerr << "错误：无法初始化识别引擎" << endl;
-        return -1;
+    namedWindow("Face Recognition", WINDOW_NORMAL);
+    
+    // 异步模式：识别在工作线程中进行，在途帧满时丢弃新帧而不是阻塞采集
+    bool useAsync = asyncWorkers > 0 && !useTieredGallery && !useShards;
+    std::mutex latestMutex;
+    RecognitionResults latestResults;
+    if (useAsync) {
+        AsyncOptions asyncOptions;
+        asyncOptions.worker_threads = asyncWorkers;
+        asyncOptions.max_in_flight = asyncWorkers;
+        asyncOptions.overflow = AsyncOverflowPolicy::REJECT;
+        asyncOptions.ordered_delivery = true;
+        recognitionEngine.configureAsync(asyncOptions);
+        if (motionGateOptions.enabled || budgetMs > 0.0) {
+            cout << "[Main] 提示：异步帧不经过运动门控与延迟预算调度器" << endl;
+        }
     }
 
-    // 5) 打开摄像头
-    VideoCapture cap(0);
-    if (!cap.isOpened()) {
-        cerr << "错误：无法打开摄像头！" << endl;
-        return -1;
+    // 追踪窗口从第一帧开始，持续 traceFrames 帧
+    int tracedFrames = 0;
+    if (!tracePath.empty()) {
+        trace::setThreadName("main");
+        trace::start();
     }
-    namedWindow("Face Recognition", WINDOW_NORMAL);
 
-    // 6) 主循环：检测 -> 识别 -> 显示
+    // 首帧完成处理、首次识别出已注册身份的时间（从进程启动算起）
+    bool firstFrameLogged = false;
+    bool firstRecognitionLogged = false;
+    RecognitionResults results;
+
+    // 4) 主循环：检测 -> 识别 -> 显示
     while (true) {
+        if (trace::enabled() && tracedFrames++ >= traceFrames) {
+            trace::stop();
+            trace::dumpJson(tracePath);
+        }
+
         Mat frame;
-        cap >> frame;
+        {
+            TRACE_SPAN("capture");
+            cap >> frame;
+        }
         if (frame.empty()) break;
 
-        // 处理当前帧
-        auto results = recognitionEngine.processFrame(
-            frame, 
-            faceManager.getKnownFeatures(), 
-            faceManager.getKnownLabels()
-        );
+        // 处理当前帧（结果缓冲区逐帧复用，标签为 LabelTable 中的ID）
+        if (useAsync) {
+            recognitionEngine.processFrameAsync(
+                frame,
+                faceManager.getIdentities(),
+                [&](uint64_t, const RecognitionResults& frameResults) {
+                    std::lock_guard<std::mutex> lock(latestMutex);
+                    latestResults = frameResults;
+                });
+            std::lock_guard<std::mutex> lock(latestMutex);
+            results = latestResults;
+        } else if (useTieredGallery) {
+            recognitionEngine.processFrame(frame, tieredGallery, results);
+        } else if (useShards) {
+            recognitionEngine.processFrame(frame, shardCoordinator, results);
+        } else {
+            // 按身份匹配：扫描代价与人数成正比，而不是照片数
+            recognitionEngine.processFrame(frame, faceManager.getIdentities(), results);
+        }
+        
+        if (!firstFrameLogged) {
+            cout << "[Startup] 首帧处理完成: " << std::fixed << std::setprecision(1) << sinceStartupMs() << " ms" << endl;
+            firstFrameLogged = true;
+        }
+        if (!firstRecognitionLogged) {
+            for (const auto& result : results) {
+                if (result.label_id != kUnknownLabel) {
+                    cout << "[Startup] 首次识别出人脸: " << LabelTable::global().name(result.label_id) << ", 距启动 "
+                         << std::fixed << std::setprecision(1) << sinceStartupMs() << " ms" << endl;
+                    firstRecognitionLogged = true;
+                    break;
+                }
+            }
+        }
         
         // 绘制识别结果
         recognitionEngine.drawResults(frame, results);
+        
+        // 显示实际帧率和调度器选择的质量等级
+        if (budgetMs > 0.0) {
+            SchedulerStats schedulerStats = recognitionEngine.getSchedulerStats();
+            std::ostringstream status;
+            status << std::fixed << std::setprecision(1) << "FPS " << schedulerStats.achieved_fps
+                   << "  Q" << schedulerStats.level << "/" << (schedulerStats.level_count - 1);
+            putText(frame, status.str(), Point(10, 25), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0, 255, 255), 2);
+        }
 
         // 显示结果
-        imshow("Face Recognition", frame);
+        int key;
+        {
+            TRACE_SPAN("display");
+            imshow("Face Recognition", frame);
+            key = waitKey(10);
+        }
         
         // ESC 退出
-        if (waitKey(10) == 27) break;
+        if (key == 27) break;
     }
 
+    if (trace::enabled()) {
+        recognitionEngine.waitAsyncIdle();
+        trace::stop();
+        trace::dumpJson(tracePath);
+    }
+
+    if (budgetMs > 0.0) {
+        SchedulerStats schedulerStats = recognitionEngine.getSchedulerStats();
+        cout << "[Main] 延迟预算: " << schedulerStats.budget_ms << " ms, 实际帧率: " << schedulerStats.achieved_fps
+             << ", 质量等级: " << schedulerStats.level << ", 等级切换: " << schedulerStats.level_changes
+             << ", 跳过检测: " << schedulerStats.detections_skipped << "/" << schedulerStats.frames << endl;
+    }
+    if (motionGateOptions.enabled) {
+        MotionGateStats gateStats = recognitionEngine.getMotionGateStats();
+        cout << "[Main] 运动门控: 跳过检测 " << gateStats.skipped << "/" << gateStats.frames
+             << " 帧 (" << std::fixed << std::setprecision(1) << gateStats.skip_ratio * 100.0 << "%)"
+             << ", 强制检测: " << gateStats.forced
+             << ", 门控耗时: " << std::setprecision(3) << gateStats.avg_gate_ms << " ms/帧"
+             << ", 检测耗时: " << gateStats.avg_detect_ms << " ms"
+             << ", 估算节省: " << std::setprecision(1) << gateStats.saved_ms << " ms" << endl;
+    }
+    if (useAsync) {
+        recognitionEngine.waitAsyncIdle();
+        AsyncStats asyncStats = recognitionEngine.getAsyncStats();
+        cout << "[Main] 异步处理: 提交 " << asyncStats.submitted << " 帧, 完成 " << asyncStats.completed
+             << " 帧, 丢弃 " << asyncStats.rejected << " 帧" << endl;
+    }
+    if (useTieredGallery) {
+        tieredGallery.printStats();
+    }
+    if (useShards) {
+        shardCoordinator.printStats();
+        shardCoordinator.stop();
+    }
+    
     cap.release();
     destroyAllWindows();
     return 0;
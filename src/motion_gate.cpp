@@ -0,0 +1,108 @@
+#include "motion_gate.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// 指数平均系数
+const double kEwmaAlpha = 0.2;
+
+inline double ewma(double current, double sample, bool first) {
+    return first ? sample : current + kEwmaAlpha * (sample - current);
+}
+
+} // namespace
+
+MotionGate::MotionGate()
+    : frames_since_detect_(0), has_detection_(false), total_gate_ms_(0.0) {
+}
+
+void MotionGate::configure(const MotionGateOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    options_.downsample_width = std::max(16, options_.downsample_width);
+    options_.background_alpha = std::min(1.0, std::max(0.0, options_.background_alpha));
+    options_.force_interval = std::max(0, options_.force_interval);
+
+    background_.release();
+    frames_since_detect_ = 0;
+    has_detection_ = false;
+    last_faces_.clear();
+    stats_ = MotionGateStats();
+    total_gate_ms_ = 0.0;
+}
+
+bool MotionGate::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_.enabled;
+}
+
+bool MotionGate::shouldDetect(const cv::Mat& frame, std::vector<cv::Rect>& reused_faces) {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.frames++;
+
+    // 1. 降采样为灰度图
+    cv::Mat small;
+    double scale = (double)options_.downsample_width / std::max(1, frame.cols);
+    if (scale < 1.0) {
+        cv::resize(frame, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    } else {
+        small = frame;
+    }
+    if (small.channels() == 3) {
+        cv::cvtColor(small, gray_, cv::COLOR_BGR2GRAY);
+    } else {
+        small.copyTo(gray_);
+    }
+    cv::GaussianBlur(gray_, gray_, cv::Size(5, 5), 0);
+
+    // 2. 与背景比较，统计变化像素比例
+    bool motion = true;
+    if (!background_.empty() && background_.size() == gray_.size()) {
+        cv::Mat background8u;
+        background_.convertTo(background8u, CV_8U);
+        cv::absdiff(gray_, background8u, diff_);
+        cv::threshold(diff_, diff_, options_.pixel_threshold, 255, cv::THRESH_BINARY);
+        stats_.last_motion_ratio = (double)cv::countNonZero(diff_) / diff_.total();
+        motion = stats_.last_motion_ratio > options_.motion_ratio;
+        cv::accumulateWeighted(gray_, background_, options_.background_alpha);
+    } else {
+        gray_.convertTo(background_, CV_32F);
+    }
+
+    // 3. 有运动、尚无检测结果或到达强制间隔时检测，否则复用上次结果
+    bool forced = options_.force_interval > 0 && frames_since_detect_ + 1 >= options_.force_interval;
+    bool detect = motion || !has_detection_ || forced;
+    if (detect) {
+        frames_since_detect_ = 0;
+        if (!motion && has_detection_) {
+            stats_.forced++;
+        }
+    } else {
+        frames_since_detect_++;
+        stats_.skipped++;
+        reused_faces = last_faces_;
+    }
+
+    double gate_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats_.avg_gate_ms = ewma(stats_.avg_gate_ms, gate_ms, stats_.frames == 1);
+    total_gate_ms_ += gate_ms;
+    return detect;
+}
+
+void MotionGate::recordDetection(double detect_ms, const std::vector<cv::Rect>& faces) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.avg_detect_ms = ewma(stats_.avg_detect_ms, detect_ms, stats_.detections == 0);
+    stats_.detections++;
+    has_detection_ = true;
+    last_faces_ = faces;
+}
+
+MotionGateStats MotionGate::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MotionGateStats stats = stats_;
+    stats.skip_ratio = stats.frames > 0 ? (double)stats.skipped / stats.frames : 0.0;
+    stats.saved_ms = stats.skipped * stats.avg_detect_ms - total_gate_ms_;
+    return stats;
+}
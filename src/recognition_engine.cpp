@@ -1,13 +1,56 @@
 #include "recognition_engine.h"
 #include "face_detection.h"
 #include "face_recognition.h"
+#include "face_manager.h"
+#include "label_table.h"
+#include "utils.h"
+#include "trace.h"
+#include "tiered_gallery.h"
+#include "shard_service.h"
+#include "yuv_frame.h"
 #include <iostream>
 #include <iomanip> // Required for std::fixed and std::setprecision
+#include <algorithm>
+#include <chrono>
 
-RecognitionEngine::RecognitionEngine() : initialized_(false) {
+namespace {
+
+// 设置 OpenCV 内部线程数（进程全局），仅在数值变化时调用，避免反复重建 OpenCV 线程池
+void setOpenCVThreads(int threads) {
+    if (cv::getNumThreads() != threads) {
+        cv::setNumThreads(threads);
+    }
+}
+
+// 记录整帧处理耗时，供延迟预算调度器调整质量等级
+class FrameTimer {
+public:
+    explicit FrameTimer(LatencyScheduler& scheduler)
+        : scheduler_(scheduler), start_(std::chrono::steady_clock::now()) {
+    }
+    
+    ~FrameTimer() {
+        if (scheduler_.enabled()) {
+            scheduler_.endFrame(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_).count());
+        }
+    }
+    
+private:
+    LatencyScheduler& scheduler_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace
+
+RecognitionEngine::RecognitionEngine()
+    : initialized_(false), parallel_configured_(false), async_configured_(false),
+      next_frame_id_(0), next_delivery_id_(0) {
 }
 
 RecognitionEngine::~RecognitionEngine() {
+    waitAsyncIdle();
+    pool_.reset();
 }
 
 bool RecognitionEngine::initialize() {
@@ -22,7 +65,9 @@ std::vector<std::pair<cv::Rect, std::string>> RecognitionEngine::processFrame(
     const std::vector<cv::Mat>& known_features,
     const std::vector<std::string>& known_labels) {
     
+    TRACE_SPAN("processFrame");
     std::vector<std::pair<cv::Rect, std::string>> results;
+    FrameTimer frame_timer(scheduler_);
     
     if (!initialized_) {
         std::cerr << "[RecognitionEngine] 错误：未初始化" << std::endl;
@@ -51,8 +96,275 @@ std::vector<std::pair<cv::Rect, std::string>> RecognitionEngine::processFrame(
     return results;
 }
 
+std::vector<std::pair<cv::Rect, std::string>> RecognitionEngine::processFrame(
+    const cv::Mat& frame,
+    const std::vector<FaceIdentity>& identities) {
+    
+    RecognitionResults results;
+    processFrame(frame, identities, results);
+    return toFrameResults(results);
+}
+
+std::vector<std::pair<cv::Rect, std::string>> RecognitionEngine::processFrame(
+    const cv::Mat& frame,
+    TieredGallery& gallery) {
+    
+    RecognitionResults results;
+    processFrame(frame, gallery, results);
+    return toFrameResults(results);
+}
+
+std::vector<std::pair<cv::Rect, std::string>> RecognitionEngine::processFrame(
+    const cv::Mat& frame,
+    ShardCoordinator& shards) {
+    
+    RecognitionResults results;
+    processFrame(frame, shards, results);
+    return toFrameResults(results);
+}
+
+void RecognitionEngine::processFrame(const cv::Mat& frame,
+                                     const std::vector<cv::Mat>& known_features,
+                                     const std::vector<uint32_t>& known_label_ids,
+                                     RecognitionResults& results) {
+    TRACE_SPAN("processFrame");
+    results.clear();
+    FrameTimer frame_timer(scheduler_);
+    
+    std::vector<cv::Rect> faces;
+    std::vector<cv::Mat> features;
+    if (detectAndExtract(frame, faces, features)) {
+        matchFaces(faces, features, known_features, known_label_ids, results);
+    }
+}
+
+void RecognitionEngine::processFrame(const cv::Mat& frame,
+                                     const std::vector<FaceIdentity>& identities,
+                                     RecognitionResults& results) {
+    TRACE_SPAN("processFrame");
+    results.clear();
+    FrameTimer frame_timer(scheduler_);
+    
+    std::vector<cv::Rect> faces;
+    std::vector<cv::Mat> features;
+    if (detectAndExtract(frame, faces, features)) {
+        matchFaces(faces, features, identities, results);
+    }
+}
+
+void RecognitionEngine::processFrame(const cv::Mat& frame,
+                                     TieredGallery& gallery,
+                                     RecognitionResults& results) {
+    TRACE_SPAN("processFrame");
+    results.clear();
+    FrameTimer frame_timer(scheduler_);
+    
+    std::vector<cv::Rect> faces;
+    std::vector<cv::Mat> features;
+    if (detectAndExtract(frame, faces, features)) {
+        matchFaces(faces, features, gallery, results);
+    }
+}
+
+void RecognitionEngine::processFrame(const cv::Mat& frame,
+                                     ShardCoordinator& shards,
+                                     RecognitionResults& results) {
+    TRACE_SPAN("processFrame");
+    results.clear();
+    FrameTimer frame_timer(scheduler_);
+    
+    std::vector<cv::Rect> faces;
+    std::vector<cv::Mat> features;
+    if (detectAndExtract(frame, faces, features)) {
+        matchFaces(faces, features, shards, results);
+    }
+}
+
+void RecognitionEngine::processFrame(const YuvFrame& frame,
+                                     const std::vector<cv::Mat>& known_features,
+                                     const std::vector<uint32_t>& known_label_ids,
+                                     RecognitionResults& results) {
+    TRACE_SPAN("processFrame");
+    results.clear();
+    FrameTimer frame_timer(scheduler_);
+    
+    std::vector<cv::Rect> faces;
+    std::vector<cv::Mat> features;
+    if (detectAndExtract(frame, faces, features)) {
+        matchFaces(faces, features, known_features, known_label_ids, results);
+    }
+}
+
+void RecognitionEngine::processFrame(const YuvFrame& frame,
+                                     const std::vector<FaceIdentity>& identities,
+                                     RecognitionResults& results) {
+    TRACE_SPAN("processFrame");
+    results.clear();
+    FrameTimer frame_timer(scheduler_);
+    
+    std::vector<cv::Rect> faces;
+    std::vector<cv::Mat> features;
+    if (detectAndExtract(frame, faces, features)) {
+        matchFaces(faces, features, identities, results);
+    }
+}
+
+void RecognitionEngine::processFrame(const YuvFrame& frame,
+                                     TieredGallery& gallery,
+                                     RecognitionResults& results) {
+    TRACE_SPAN("processFrame");
+    results.clear();
+    FrameTimer frame_timer(scheduler_);
+    
+    std::vector<cv::Rect> faces;
+    std::vector<cv::Mat> features;
+    if (detectAndExtract(frame, faces, features)) {
+        matchFaces(faces, features, gallery, results);
+    }
+}
+
+void RecognitionEngine::processFrame(const YuvFrame& frame,
+                                     ShardCoordinator& shards,
+                                     RecognitionResults& results) {
+    TRACE_SPAN("processFrame");
+    results.clear();
+    FrameTimer frame_timer(scheduler_);
+    
+    std::vector<cv::Rect> faces;
+    std::vector<cv::Mat> features;
+    if (detectAndExtract(frame, faces, features)) {
+        matchFaces(faces, features, shards, results);
+    }
+}
+
+void RecognitionEngine::matchFaces(const std::vector<cv::Rect>& faces,
+                                   const std::vector<cv::Mat>& features,
+                                   const std::vector<cv::Mat>& known_features,
+                                   const std::vector<uint32_t>& known_label_ids,
+                                   RecognitionResults& results) {
+    results.resize(faces.size());
+    for (size_t i = 0; i < faces.size(); ++i) {
+        results[i].rect = faces[i];
+        matchFace(features[i], known_features, known_label_ids, results[i]);
+    }
+}
+
+void RecognitionEngine::matchFaces(const std::vector<cv::Rect>& faces,
+                                   const std::vector<cv::Mat>& features,
+                                   const std::vector<FaceIdentity>& identities,
+                                   RecognitionResults& results) {
+    // 按身份匹配
+    results.resize(faces.size());
+    for (size_t i = 0; i < faces.size(); ++i) {
+        results[i].rect = faces[i];
+        matchIdentity(features[i], identities, results[i]);
+    }
+}
+
+void RecognitionEngine::matchFaces(const std::vector<cv::Rect>& faces,
+                                   const std::vector<cv::Mat>& features,
+                                   TieredGallery& gallery,
+                                   RecognitionResults& results) {
+    // 在分层图库中匹配；图库直接返回标签ID（身份换入热层时驻留）
+    results.resize(faces.size());
+    for (size_t i = 0; i < faces.size(); ++i) {
+        results[i] = RecognitionResult();
+        results[i].rect = faces[i];
+        
+        size_t best_index = 0;
+        uint32_t best_label_id = kUnknownLabel;
+        double best_similarity = -1.0;
+        if (gallery.findBestMatch(features[i], best_index, best_label_id, best_similarity)) {
+            resolveMatch(best_label_id, best_similarity, results[i]);
+        }
+    }
+}
+
+void RecognitionEngine::matchFaces(const std::vector<cv::Rect>& faces,
+                                   const std::vector<cv::Mat>& features,
+                                   ShardCoordinator& shards,
+                                   RecognitionResults& results) {
+    // 分发到各分片匹配并合并结果
+    std::vector<ShardMatch> matches;
+    results.resize(faces.size());
+    for (size_t i = 0; i < faces.size(); ++i) {
+        results[i] = RecognitionResult();
+        results[i].rect = faces[i];
+        if (shards.query(features[i], 1, matches) && !matches.empty()) {
+            resolveMatch(matches[0].label_id, matches[0].similarity, results[i]);
+        }
+    }
+}
+
+bool RecognitionEngine::detectAndExtract(const cv::Mat& frame,
+                                         std::vector<cv::Rect>& faces,
+                                         std::vector<cv::Mat>& features) {
+    if (!initialized_) {
+        std::cerr << "[RecognitionEngine] 错误：未初始化" << std::endl;
+        return false;
+    }
+    
+    // 1. 人脸检测
+    faces = detectFaces(frame);
+    if (faces.empty()) {
+        return false;
+    }
+    
+    // 2. 特征提取
+    features = extractFeatures(frame, faces);
+    if (features.size() != faces.size()) {
+        std::cerr << "[RecognitionEngine] 特征提取数量不匹配" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool RecognitionEngine::detectAndExtract(const YuvFrame& frame,
+                                         std::vector<cv::Rect>& faces,
+                                         std::vector<cv::Mat>& features) {
+    if (!initialized_) {
+        std::cerr << "[RecognitionEngine] 错误：未初始化" << std::endl;
+        return false;
+    }
+    if (frame.empty()) {
+        return false;
+    }
+    
+    // 1. 人脸检测：直接使用亮度平面（运动门控同样只看亮度），整帧不做颜色转换
+    faces = detectFaces(frame.y);
+    if (faces.empty()) {
+        return false;
+    }
+    
+    // 2. 只把人脸区域转换为BGR，再提取特征
+    std::vector<cv::Mat> crops(faces.size());
+    {
+        TRACE_SPAN("yuvCrops");
+        for (size_t i = 0; i < faces.size(); ++i) {
+            yuvCropToBgr(frame, faces[i], crops[i]);
+        }
+    }
+    features = extractFeatures(crops);
+    if (features.size() != faces.size()) {
+        std::cerr << "[RecognitionEngine] 特征提取数量不匹配" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+FrameResults RecognitionEngine::toFrameResults(const RecognitionResults& results) {
+    FrameResults named;
+    named.reserve(results.size());
+    for (const auto& result : results) {
+        named.push_back({result.rect, LabelTable::global().name(result.label_id)});
+    }
+    return named;
+}
+
 void RecognitionEngine::drawResults(cv::Mat& frame, 
                                    const std::vector<std::pair<cv::Rect, std::string>>& results) {
+    TRACE_SPAN("drawResults");
+    // 兼容字符串结果的接口：逐个测量文字尺寸，不查询标签表（逐帧绘制请使用 RecognitionResults 版本）
     for (const auto& result : results) {
         const cv::Rect& rect = result.first;
         const std::string& name = result.second;
@@ -61,92 +373,564 @@ void RecognitionEngine::drawResults(cv::Mat& frame,
         cv::rectangle(frame, rect, cv::Scalar(0, 255, 0), 2);
         
         // 绘制标签
-        drawLabel(frame, rect, name);
+        drawLabel(frame, rect, name, cv::getTextSize(name, cv::FONT_HERSHEY_SIMPLEX, 0.6, 2, nullptr));
+    }
+}
+
+void RecognitionEngine::drawResults(cv::Mat& frame, const RecognitionResults& results) {
+    TRACE_SPAN("drawResults");
+    for (const auto& result : results) {
+        // 绘制人脸框
+        cv::rectangle(frame, result.rect, cv::Scalar(0, 255, 0), 2);
+        
+        // 绘制标签
+        drawLabel(frame, result.rect, LabelTable::global().name(result.label_id), labelExtent(result.label_id));
     }
 }
 
 std::vector<cv::Rect> RecognitionEngine::detectFaces(const cv::Mat& frame) {
-    return ::detectFaces(frame);
+    // 调度器的逐帧统计（帧数、实际帧率）每帧只记一次，门控跳过的帧同样计入
+    const bool scheduled = scheduler_.enabled();
+    if (scheduled) {
+        scheduler_.beginFrame();
+    }
+    
+    // 画面静止时复用上次检测结果
+    std::vector<cv::Rect> faces;
+    const bool gated = motion_gate_.enabled();
+    if (gated) {
+        bool detect;
+        {
+            TRACE_SPAN("motionGate");
+            detect = motion_gate_.shouldDetect(frame, faces);
+        }
+        if (!detect) {
+            return faces;
+        }
+    }
+    
+    // 由调度器决定本帧是否检测以及使用的检测参数
+    DetectionParams params;
+    if (scheduled && !scheduler_.shouldDetect(params, faces)) {
+        return faces; // 复用上次检测结果
+    }
+    
+    // 只有级联实际运行时才向调度器和门控记录检测耗时
+    auto start = std::chrono::steady_clock::now();
+    faces = ::detectFaces(frame, params);
+    double detect_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (scheduled) {
+        scheduler_.recordDetection(detect_ms, faces);
+    }
+    if (gated) {
+        motion_gate_.recordDetection(detect_ms, faces);
+    }
+    return faces;
 }
 
 std::vector<cv::Mat> RecognitionEngine::extractFeatures(const cv::Mat& frame, 
                                                        const std::vector<cv::Rect>& faces) {
-    return ::extract_face_features(frame, faces);
+    // 越界的人脸区域留空，提取时跳过（与逐张提取的约定一致）
+    const cv::Rect bounds(0, 0, frame.cols, frame.rows);
+    std::vector<cv::Mat> crops(faces.size());
+    for (size_t i = 0; i < faces.size(); ++i) {
+        if (!faces[i].empty() && (faces[i] & bounds) == faces[i]) {
+            crops[i] = frame(faces[i]);
+        }
+    }
+    return extractFeatures(crops);
+}
+
+std::vector<cv::Mat> RecognitionEngine::extractFeatures(const std::vector<cv::Mat>& crops) {
+    if (crops.size() == 1) {
+        if (crops[0].empty()) {
+            return {};
+        }
+        return ::extract_face_features(crops[0], {cv::Rect(0, 0, crops[0].cols, crops[0].rows)});
+    }
+    
+    // 多张人脸走批量提取
+    std::vector<cv::Mat> batch = extractFeatureBatch(crops);
+    
+    // 与逐张提取的返回约定一致：只保留成功提取的特征
+    std::vector<cv::Mat> features;
+    features.reserve(batch.size());
+    for (auto& face_features : batch) {
+        if (!face_features.empty()) {
+            features.push_back(face_features);
+        }
+    }
+    return features;
+}
+
+std::vector<cv::Mat> RecognitionEngine::extractFeatureBatch(const std::vector<cv::Mat>& crops) {
+    // INTER_FACE 策略下各批分发到线程池，在线程池内部调用时（异步帧）parallelFor 会串行执行
+    ThreadPool* pool = nullptr;
+    if (parallel_configured_ && parallel_options_.extraction == ParallelPolicy::INTER_FACE) {
+        pool = pool_.get();
+    }
+    return ::extract_face_features_batch(crops, pool);
+}
+
+void RecognitionEngine::applyOpenCVThreads() {
+    if (!parallel_configured_) {
+        return; // 未配置时保持 OpenCV 默认线程数
+    }
+    
+    // OpenCV 线程数是进程全局设置，只在配置时确定一次，不随阶段逐帧切换：
+    // 异步帧已在线程池上按帧并行，OpenCV 内部不再并行；否则任一阶段使用 INTRA_OPENCV 时取线程预算
+    int threads = 1;
+    if (!async_configured_ && (parallel_options_.detection == ParallelPolicy::INTRA_OPENCV ||
+                               parallel_options_.extraction == ParallelPolicy::INTRA_OPENCV)) {
+        threads = (int)parallel_options_.threads;
+    }
+    setOpenCVThreads(threads);
+}
+
+void RecognitionEngine::setLatencyBudget(double budget_ms) {
+    scheduler_.setBudgetMs(budget_ms);
+    if (budget_ms > 0.0) {
+        std::cout << "[RecognitionEngine] 每帧延迟预算: " << budget_ms << " ms" << std::endl;
+    }
+}
+
+SchedulerStats RecognitionEngine::getSchedulerStats() const {
+    return scheduler_.getStats();
+}
+
+void RecognitionEngine::setMotionGate(const MotionGateOptions& options) {
+    motion_gate_.configure(options);
+    if (options.enabled) {
+        std::cout << "[RecognitionEngine] 运动门控已启用 (变化比例阈值: " << options.motion_ratio
+                  << ", 强制检测间隔: " << options.force_interval << " 帧)" << std::endl;
+    }
+}
+
+MotionGateStats RecognitionEngine::getMotionGateStats() const {
+    return motion_gate_.getStats();
+}
+
+void RecognitionEngine::configureParallel(const ParallelOptions& options) {
+    waitAsyncIdle();
+    
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    parallel_options_ = options;
+    if (parallel_options_.threads == 0) {
+        parallel_options_.threads = std::max<size_t>(1, ThreadPool::availableCpus().size());
+    }
+    if (parallel_options_.detection == ParallelPolicy::INTER_FACE) {
+        parallel_options_.detection = ParallelPolicy::INTRA_OPENCV;
+    }
+    
+    ThreadPoolOptions pool_options;
+    pool_options.num_threads = parallel_options_.threads;
+    pool_options.affinity = parallel_options_.affinity;
+    pool_.reset(new ThreadPool(pool_options));
+    parallel_configured_ = true;
+    applyOpenCVThreads();
+    
+    const char* policy_names[] = {"SERIAL", "INTRA_OPENCV", "INTER_FACE"};
+    const char* affinity_names[] = {"无", "按核心", "按NUMA节点"};
+    std::cout << "[RecognitionEngine] 并行配置: " << parallel_options_.threads << " 个线程"
+              << ", 绑定: " << affinity_names[(int)parallel_options_.affinity]
+              << ", 检测: " << policy_names[(int)parallel_options_.detection]
+              << ", 特征提取: " << policy_names[(int)parallel_options_.extraction] << std::endl;
+}
+
+void RecognitionEngine::configureAsync(const AsyncOptions& options) {
+    waitAsyncIdle();
+    
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    async_options_ = options;
+    async_options_.worker_threads = std::max<size_t>(1, async_options_.worker_threads);
+    async_options_.max_in_flight = std::max<size_t>(1, async_options_.max_in_flight);
+    if (!parallel_configured_) {
+        pool_.reset(new ThreadPool(async_options_.worker_threads));
+    }
+    async_configured_ = true;
+    applyOpenCVThreads();
+    
+    {
+        std::lock_guard<std::mutex> delivery_lock(delivery_mutex_);
+        pending_delivery_.clear();
+        next_delivery_id_ = next_frame_id_;
+    }
+    
+    std::cout << "[RecognitionEngine] 异步处理: " << pool_->size() << " 个工作线程, "
+              << "最大在途帧数: " << async_options_.max_in_flight
+              << (async_options_.overflow == AsyncOverflowPolicy::REJECT ? ", 超限拒绝" : ", 超限阻塞")
+              << (async_options_.ordered_delivery ? ", 有序交付" : "") << std::endl;
+}
+
+std::future<RecognitionResults> RecognitionEngine::processFrameAsync(
+    const cv::Mat& frame,
+    const std::vector<FaceIdentity>& identities) {
+    
+    uint64_t frame_id = 0;
+    if (!acquireSlot(frame_id)) {
+        return std::future<RecognitionResults>();
+    }
+    
+    auto promise = std::make_shared<std::promise<RecognitionResults>>();
+    std::future<RecognitionResults> future = promise->get_future();
+    cv::Mat copy = frame.clone();
+    
+    pool_->enqueue([this, copy, &identities, promise, frame_id]() {
+        RecognitionResults results;
+        try {
+            processAsyncFrame(copy, identities, results);
+            promise->set_value(results);
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+        // 有序模式下 future 帧同样占用序号，需要推进交付位置
+        deliver(frame_id, std::move(results), FrameCallback());
+        releaseSlot();
+    });
+    
+    return future;
+}
+
+bool RecognitionEngine::processFrameAsync(
+    const cv::Mat& frame,
+    const std::vector<FaceIdentity>& identities,
+    FrameCallback callback) {
+    
+    uint64_t frame_id = 0;
+    if (!acquireSlot(frame_id)) {
+        return false;
+    }
+    
+    cv::Mat copy = frame.clone();
+    pool_->enqueue([this, copy, &identities, callback, frame_id]() {
+        RecognitionResults results;
+        try {
+            processAsyncFrame(copy, identities, results);
+        } catch (const std::exception& e) {
+            std::cerr << "[RecognitionEngine] 异步处理失败: " << e.what() << std::endl;
+            results.clear();
+        } catch (...) {
+            std::cerr << "[RecognitionEngine] 异步处理失败: 未知异常" << std::endl;
+            results.clear();
+        }
+        // 处理失败时仍交付（空结果）并释放名额，有序交付不会停在这一帧
+        deliver(frame_id, std::move(results), callback);
+        releaseSlot();
+    });
+    
+    return true;
+}
+
+void RecognitionEngine::processAsyncFrame(const cv::Mat& frame, const std::vector<FaceIdentity>& identities,
+                                          RecognitionResults& results) {
+    TRACE_SPAN("processFrame");
+    results.clear();
+    if (!initialized_) {
+        std::cerr << "[RecognitionEngine] 错误：未初始化" << std::endl;
+        return;
+    }
+    
+    // 1. 人脸检测（不经过运动门控与调度器）
+    std::vector<cv::Rect> faces = ::detectFaces(frame);
+    if (faces.empty()) {
+        return;
+    }
+    
+    // 2. 特征提取
+    std::vector<cv::Mat> features = extractFeatures(frame, faces);
+    if (features.size() != faces.size()) {
+        std::cerr << "[RecognitionEngine] 特征提取数量不匹配" << std::endl;
+        return;
+    }
+    
+    // 3. 按身份匹配
+    matchFaces(faces, features, identities, results);
+}
+
+void RecognitionEngine::waitAsyncIdle() {
+    std::unique_lock<std::mutex> lock(async_mutex_);
+    async_cv_.wait(lock, [this] { return async_stats_.in_flight == 0; });
+}
+
+AsyncStats RecognitionEngine::getAsyncStats() const {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    return async_stats_;
+}
+
+bool RecognitionEngine::acquireSlot(uint64_t& frame_id) {
+    std::unique_lock<std::mutex> lock(async_mutex_);
+    if (!pool_) {
+        pool_.reset(new ThreadPool(async_options_.worker_threads));
+    }
+    
+    if (async_stats_.in_flight >= async_options_.max_in_flight) {
+        if (async_options_.overflow == AsyncOverflowPolicy::REJECT) {
+            async_stats_.rejected++;
+            return false;
+        }
+        // 背压：等待在途帧完成
+        async_cv_.wait(lock, [this] { return async_stats_.in_flight < async_options_.max_in_flight; });
+    }
+    
+    async_stats_.in_flight++;
+    async_stats_.peak_in_flight = std::max(async_stats_.peak_in_flight, async_stats_.in_flight);
+    async_stats_.submitted++;
+    frame_id = next_frame_id_++;
+    return true;
+}
+
+void RecognitionEngine::releaseSlot() {
+    {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        async_stats_.in_flight--;
+        async_stats_.completed++;
+    }
+    async_cv_.notify_all();
+}
+
+void RecognitionEngine::deliver(uint64_t frame_id, RecognitionResults results, const FrameCallback& callback) {
+    if (!async_options_.ordered_delivery) {
+        invokeCallback(callback, frame_id, results);
+        return;
+    }
+    
+    // 按帧序号依次交付，前序帧未完成时先缓存
+    std::lock_guard<std::mutex> lock(delivery_mutex_);
+    pending_delivery_[frame_id] = std::make_pair(std::move(results), callback);
+    while (!pending_delivery_.empty() && pending_delivery_.begin()->first == next_delivery_id_) {
+        auto it = pending_delivery_.begin();
+        invokeCallback(it->second.second, it->first, it->second.first);
+        pending_delivery_.erase(it);
+        next_delivery_id_++;
+    }
+}
+
+void RecognitionEngine::invokeCallback(const FrameCallback& callback, uint64_t frame_id,
+                                       const RecognitionResults& results) {
+    if (!callback) {
+        return;
+    }
+    // 回调抛出的异常不能越过交付：否则名额不会释放，有序交付会一直停在这一帧
+    try {
+        callback(frame_id, results);
+    } catch (const std::exception& e) {
+        std::cerr << "[RecognitionEngine] 帧 " << frame_id << " 的回调异常: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "[RecognitionEngine] 帧 " << frame_id << " 的回调异常: 未知异常" << std::endl;
+    }
 }
 
 std::string RecognitionEngine::matchFace(const cv::Mat& features,
                                          const std::vector<cv::Mat>& known_features,
-                                         const std::vector<std::string>& known_labels) {
+                                         const std::vector<std::string>& known_labels,
+                                         double* similarity_out) {
+    TRACE_SPAN("matchFace");
+    if (similarity_out) {
+        *similarity_out = -1.0;
+    }
     if (known_features.empty() || known_labels.empty()) {
         return "Unknown";
     }
     
-    std::string best_match = "Unknown";
     double best_similarity = -1.0;
-    int best_index = -1;
+    size_t best_index = findBestSample(features, known_features, best_similarity);
+    
+    if (similarity_out) {
+        *similarity_out = best_similarity;
+    }
+    double threshold = 0.0;
+    bool accepted = passesMatchThreshold(best_similarity, threshold);
+    logMatchDecision(known_labels[best_index], best_similarity, threshold);
+    if (!accepted) {
+        return "Unknown";
+    }
+    return known_labels[best_index];
+}
+
+void RecognitionEngine::matchFace(const cv::Mat& features,
+                                  const std::vector<cv::Mat>& known_features,
+                                  const std::vector<uint32_t>& known_label_ids,
+                                  RecognitionResult& result) {
+    TRACE_SPAN("matchFace");
+    result.label_id = kUnknownLabel;
+    result.similarity = -1.0f;
+    result.confidence = 0.0f;
+    if (known_features.empty() || known_label_ids.empty()) {
+        return;
+    }
+    
+    double best_similarity = -1.0;
+    size_t best_index = findBestSample(features, known_features, best_similarity);
+    resolveMatch(known_label_ids[best_index], best_similarity, result);
+}
+
+std::string RecognitionEngine::matchIdentity(const cv::Mat& features,
+                                             const std::vector<FaceIdentity>& identities,
+                                             size_t candidate_count,
+                                             double* similarity_out) {
+    TRACE_SPAN("matchIdentity");
+    if (similarity_out) {
+        *similarity_out = -1.0;
+    }
+    if (identities.empty()) {
+        return "Unknown";
+    }
     
-    // 计算所有相似度并找到最佳匹配
+    double best_similarity = -1.0;
+    size_t best_identity = findBestIdentity(features, identities, candidate_count, best_similarity);
+    
+    if (similarity_out) {
+        *similarity_out = best_similarity;
+    }
+    double threshold = 0.0;
+    bool accepted = passesMatchThreshold(best_similarity, threshold);
+    logMatchDecision(identities[best_identity].label, best_similarity, threshold);
+    if (!accepted) {
+        return "Unknown";
+    }
+    return identities[best_identity].label;
+}
+
+void RecognitionEngine::matchIdentity(const cv::Mat& features,
+                                      const std::vector<FaceIdentity>& identities,
+                                      RecognitionResult& result,
+                                      size_t candidate_count) {
+    TRACE_SPAN("matchIdentity");
+    result.label_id = kUnknownLabel;
+    result.similarity = -1.0f;
+    result.confidence = 0.0f;
+    if (identities.empty()) {
+        return;
+    }
+    
+    double best_similarity = -1.0;
+    size_t best_identity = findBestIdentity(features, identities, candidate_count, best_similarity);
+    resolveMatch(identities[best_identity].label_id, best_similarity, result);
+}
+
+size_t RecognitionEngine::findBestSample(const cv::Mat& features,
+                                         const std::vector<cv::Mat>& known_features,
+                                         double& best_similarity) {
+    // 计算所有相似度并记录最佳匹配的下标（不复制标签）
+    size_t best_index = 0;
+    best_similarity = -1.0;
     for (size_t i = 0; i < known_features.size(); ++i) {
         double similarity = ::compare_faces(features, known_features[i]);
         
         if (similarity > best_similarity) {
             best_similarity = similarity;
-            best_match = known_labels[i];
             best_index = i;
         }
     }
+    return best_index;
+}
+
+size_t RecognitionEngine::findBestIdentity(const cv::Mat& features,
+                                           const std::vector<FaceIdentity>& identities,
+                                           size_t candidate_count,
+                                           double& best_similarity) {
+    // 1. 第一轮：与每个身份的平均模板比对，代价与人数成正比（候选缓冲区按线程复用）
+    thread_local std::vector<std::pair<double, size_t>> candidates;
+    candidates.clear();
+    for (size_t i = 0; i < identities.size(); ++i) {
+        candidates.push_back({::utils::cosineSimilarity(features, identities[i].centroid), i});
+    }
     
-    // 多阈值动态匹配策略
-    double final_threshold = 0.6; // 默认阈值
+    size_t keep = std::min(std::max<size_t>(1, candidate_count), candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end(),
+                      [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) {
+                          return a.first > b.first;
+                      });
     
+    // 2. 第二轮：仅对候选身份比对全部样本，取最高相似度
+    best_similarity = -1.0;
+    size_t best_identity = candidates[0].second;
+    for (size_t c = 0; c < keep; ++c) {
+        const FaceIdentity& identity = identities[candidates[c].second];
+        for (const auto& sample : identity.samples) {
+            double similarity = ::utils::cosineSimilarity(features, sample);
+            if (similarity > best_similarity) {
+                best_similarity = similarity;
+                best_identity = candidates[c].second;
+            }
+        }
+    }
+    return best_identity;
+}
+
+void RecognitionEngine::resolveMatch(uint32_t best_label_id, double best_similarity, RecognitionResult& result) {
+    // 按ID匹配的路径不输出日志，也不读取标签名
+    double threshold = 0.0;
+    bool accepted = passesMatchThreshold(best_similarity, threshold);
+    
+    result.label_id = accepted ? best_label_id : kUnknownLabel;
+    result.similarity = (float)best_similarity;
+    // 置信度：相似度超出阈值的部分占阈值到 1 之间距离的比例
+    result.confidence = accepted && threshold < 1.0
+        ? (float)std::min(1.0, std::max(0.0, (best_similarity - threshold) / (1.0 - threshold)))
+        : 0.0f;
+}
+
+bool RecognitionEngine::passesMatchThreshold(double best_similarity, double& threshold) {
+    // 多阈值动态匹配策略
     if (best_similarity >= 0.95) {
         // 极高相似度：使用严格阈值
-        final_threshold = 0.90;
-        std::cout << "[RecognitionEngine] 极高相似度: " << best_match 
-                  << " (" << std::fixed << std::setprecision(3) << best_similarity 
-                  << "), 阈值: " << final_threshold << std::endl;
+        threshold = 0.90;
     }
     else if (best_similarity >= 0.85) {
         // 高相似度：使用较高阈值
-        final_threshold = 0.75;
-        std::cout << "[RecognitionEngine] 高相似度: " << best_match 
-                  << " (" << std::fixed << std::setprecision(3) << best_similarity 
-                  << "), 阈值: " << final_threshold << std::endl;
+        threshold = 0.75;
     }
     else if (best_similarity >= 0.75) {
         // 中等相似度：使用中等阈值
-        final_threshold = 0.65;
-        std::cout << "[RecognitionEngine] 中等相似度: " << best_match 
-                  << " (" << std::fixed << std::setprecision(3) << best_similarity 
-                  << "), 阈值: " << final_threshold << std::endl;
+        threshold = 0.65;
     }
     else {
         // 低相似度：使用宽松阈值但标记为低置信度
-        final_threshold = 0.60;
-        std::cout << "[RecognitionEngine] 低相似度: " << best_match 
-                  << " (" << std::fixed << std::setprecision(3) << best_similarity 
-                  << "), 阈值: " << final_threshold << std::endl;
+        threshold = 0.60;
     }
+    return best_similarity >= threshold;
+}
+
+void RecognitionEngine::logMatchDecision(const std::string& best_match, double best_similarity, double threshold) {
+    const char* level = best_similarity >= 0.95 ? "极高相似度"
+                      : best_similarity >= 0.85 ? "高相似度"
+                      : best_similarity >= 0.75 ? "中等相似度" : "低相似度";
+    std::cout << "[RecognitionEngine] " << level << ": " << best_match
+              << " (" << std::fixed << std::setprecision(3) << best_similarity
+              << "), 阈值: " << threshold << std::endl;
     
-    // 应用最终阈值判断
-    if (best_similarity >= final_threshold) {
-        // 额外检查：如果相似度接近阈值，进行二次验证
-        if (best_similarity < final_threshold + 0.05) {
+    if (best_similarity >= threshold) {
+        // 额外检查：如果相似度接近阈值，建议二次验证
+        if (best_similarity < threshold + 0.05) {
             std::cout << "[RecognitionEngine] 低置信度匹配，建议二次验证" << std::endl;
         }
-        return best_match;
     } else {
         std::cout << "[RecognitionEngine] 相似度低于阈值，标记为Unknown" << std::endl;
-        return "Unknown";
     }
 }
 
-void RecognitionEngine::drawLabel(cv::Mat& frame, const cv::Rect& rect, const std::string& text) {
-    int base = 0;
-    cv::Size sz = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, 0.6, 2, &base);
-    
-    cv::Rect bg(rect.x, std::max(0, rect.y - sz.height - 8), 
-                sz.width + 8, sz.height + 8);
+cv::Size RecognitionEngine::labelExtent(uint32_t label_id) {
+    std::lock_guard<std::mutex> lock(label_extent_mutex_);
+    // 未驻留或无效的ID按 Unknown 处理（与 LabelTable::name 一致），不能越界写入缓存
+    const size_t label_count = LabelTable::global().size();
+    if (label_id >= label_count) {
+        label_id = kUnknownLabel;
+    }
+    if (label_id >= label_extents_.size()) {
+        label_extents_.resize(label_count);
+    }
+    // 每个标签只测量一次文字尺寸
+    cv::Size& extent = label_extents_[label_id];
+    if (extent.width == 0) {
+        extent = cv::getTextSize(LabelTable::global().name(label_id), cv::FONT_HERSHEY_SIMPLEX, 0.6, 2, nullptr);
+    }
+    return extent;
+}
+
+void RecognitionEngine::drawLabel(cv::Mat& frame, const cv::Rect& rect, const std::string& text, const cv::Size& text_size) {
+    cv::Rect bg(rect.x, std::max(0, rect.y - text_size.height - 8), 
+                text_size.width + 8, text_size.height + 8);
     
     cv::rectangle(frame, bg, cv::Scalar(0, 0, 0), cv::FILLED);
     cv::putText(frame, text, cv::Point(bg.x + 4, bg.y + bg.height - 6),
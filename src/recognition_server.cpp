@@ -0,0 +1,393 @@
+#include "recognition_server.h"
+#include "recognition_engine.h"
+#include "face_detection.h"
+#include "face_manager.h"
+#include "face_recognition.h"
+#include "ipc.h"
+#include "label_table.h"
+#include "trace.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// 延迟统计保留最近的请求数
+const size_t kLatencyWindow = 4096;
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, (size_t)(values.size() * p));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+} // namespace
+
+RecognitionServer::RecognitionServer(RecognitionEngine& engine, const std::vector<FaceIdentity>& identities)
+    : engine_(engine), identities_(&identities), gallery_(nullptr), shards_(nullptr),
+      listen_fd_(-1), running_(false), active_connections_(0), latency_pos_(0) {
+}
+
+RecognitionServer::RecognitionServer(RecognitionEngine& engine, TieredGallery& gallery)
+    : engine_(engine), identities_(nullptr), gallery_(&gallery), shards_(nullptr),
+      listen_fd_(-1), running_(false), active_connections_(0), latency_pos_(0) {
+}
+
+RecognitionServer::RecognitionServer(RecognitionEngine& engine, ShardCoordinator& shards)
+    : engine_(engine), identities_(nullptr), gallery_(nullptr), shards_(&shards),
+      listen_fd_(-1), running_(false), active_connections_(0), latency_pos_(0) {
+}
+
+RecognitionServer::~RecognitionServer() {
+    stop();
+}
+
+bool RecognitionServer::start(const ServerConfig& config) {
+    if (running_) {
+        return true;
+    }
+
+    config_ = config;
+    config_.max_batch_size = std::max<size_t>(1, config_.max_batch_size);
+    config_.max_wait_ms = std::max(0, config_.max_wait_ms);
+
+    listen_fd_ = ipc::listenUnix(config_.socket_path, 64);
+    if (listen_fd_ < 0) {
+        std::cerr << "[RecognitionServer] 错误：无法监听 " << config_.socket_path << std::endl;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_ = ServerStats();
+        latencies_.clear();
+        latency_pos_ = 0;
+        start_time_ = std::chrono::steady_clock::now();
+    }
+
+    running_ = true;
+    batch_thread_ = std::thread(&RecognitionServer::batchLoop, this);
+    accept_thread_ = std::thread(&RecognitionServer::acceptLoop, this);
+
+    std::cout << "[RecognitionServer] 启动成功: " << config_.socket_path
+              << " (最大批大小: " << config_.max_batch_size
+              << ", 最大等待: " << config_.max_wait_ms << " ms)" << std::endl;
+    return true;
+}
+
+void RecognitionServer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    queue_cv_.notify_all();
+
+    // 1. 停止接受新连接
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    ipc::closeSocket(listen_fd_);
+    listen_fd_ = -1;
+    ::unlink(config_.socket_path.c_str());
+
+    // 2. 处理完队列中剩余的请求
+    if (batch_thread_.joinable()) {
+        batch_thread_.join();
+    }
+
+    // 3. 断开所有连接并等待连接线程退出
+    std::unique_lock<std::mutex> lock(connections_mutex_);
+    for (int fd : connection_fds_) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    connections_cv_.wait(lock, [this] { return active_connections_ == 0; });
+
+    std::cout << "[RecognitionServer] 已停止" << std::endl;
+}
+
+bool RecognitionServer::isRunning() const {
+    return running_;
+}
+
+ServerStats RecognitionServer::getStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ServerStats stats = stats_;
+
+    double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+    stats.throughput = uptime > 0.0 ? stats.requests / uptime : 0.0;
+    stats.mean_batch_size = stats.batches > 0 ? (double)stats.requests / stats.batches : 0.0;
+    stats.p50_latency_ms = percentile(latencies_, 0.50);
+    stats.p99_latency_ms = percentile(latencies_, 0.99);
+    return stats;
+}
+
+void RecognitionServer::printStats() const {
+    ServerStats stats = getStats();
+    std::cout << "[RecognitionServer] 请求: " << stats.requests
+              << ", 批次: " << stats.batches
+              << ", 人脸: " << stats.faces
+              << ", 平均批大小: " << std::fixed << std::setprecision(2) << stats.mean_batch_size
+              << ", 吞吐量: " << stats.throughput << " req/s"
+              << ", p50: " << stats.p50_latency_ms << " ms"
+              << ", p99: " << stats.p99_latency_ms << " ms" << std::endl;
+}
+
+void RecognitionServer::acceptLoop() {
+    while (running_) {
+        pollfd pfd = {listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connection_fds_.push_back(fd);
+        active_connections_++;
+        std::thread(&RecognitionServer::connectionLoop, this, fd).detach();
+    }
+}
+
+void RecognitionServer::connectionLoop(int fd) {
+    std::vector<uint8_t> payload;
+
+    while (running_ && ipc::recvMessage(fd, payload)) {
+        ipc::Reader reader(payload);
+        uint8_t type = reader.getU8();
+        ipc::Writer writer;
+
+        if (reader.ok() && type == REQUEST_STATS) {
+            ServerStats stats = getStats();
+            writer.putU8(STATUS_OK);
+            writer.putU32((uint32_t)config_.max_batch_size);
+            writer.putU32((uint32_t)config_.max_wait_ms);
+            writer.putF64((double)stats.requests);
+            writer.putF64((double)stats.batches);
+            writer.putF64(stats.mean_batch_size);
+            writer.putF64(stats.throughput);
+            writer.putF64(stats.p50_latency_ms);
+            writer.putF64(stats.p99_latency_ms);
+            if (!ipc::sendMessage(fd, writer.buffer())) {
+                break;
+            }
+            continue;
+        }
+
+        // 在连接线程中解码，解码开销随连接数并行
+        cv::Mat image;
+        if (reader.ok() && (type == REQUEST_IMAGE || type == REQUEST_FACE) && reader.remaining() > 0) {
+            size_t size = reader.remaining();
+            cv::Mat encoded(1, (int)size, CV_8U, const_cast<uint8_t*>(reader.skipBytes(size)));
+            image = cv::imdecode(encoded, cv::IMREAD_COLOR);
+        }
+
+        if (image.empty()) {
+            writer.putU8(STATUS_BAD_REQUEST);
+            writer.putU32(0);
+            if (!ipc::sendMessage(fd, writer.buffer())) {
+                break;
+            }
+            continue;
+        }
+
+        // 加入批处理队列
+        std::future<std::vector<FaceResult>> future;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            if (running_) {
+                PendingRequest request;
+                request.type = (ServerRequestType)type;
+                request.image = image;
+                request.arrival = std::chrono::steady_clock::now();
+                future = request.result.get_future();
+                queue_.push_back(std::move(request));
+            }
+        }
+
+        if (!future.valid()) {
+            writer.putU8(STATUS_UNAVAILABLE);
+            writer.putU32(0);
+            ipc::sendMessage(fd, writer.buffer());
+            break;
+        }
+        queue_cv_.notify_one();
+
+        std::vector<FaceResult> results;
+        try {
+            results = future.get();
+        } catch (...) {
+            writer.putU8(STATUS_BAD_REQUEST);
+            writer.putU32(0);
+            if (!ipc::sendMessage(fd, writer.buffer())) {
+                break;
+            }
+            continue;
+        }
+        writer.putU8(STATUS_OK);
+        writer.putU32((uint32_t)results.size());
+        for (const auto& result : results) {
+            writer.putI32(result.rect.x);
+            writer.putI32(result.rect.y);
+            writer.putI32(result.rect.width);
+            writer.putI32(result.rect.height);
+            writer.putF64(result.similarity);
+            writer.putString(LabelTable::global().name(result.label_id));
+        }
+        if (!ipc::sendMessage(fd, writer.buffer())) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    connection_fds_.erase(std::remove(connection_fds_.begin(), connection_fds_.end(), fd),
+                          connection_fds_.end());
+    ipc::closeSocket(fd);
+    active_connections_--;
+    connections_cv_.notify_all();
+}
+
+void RecognitionServer::batchLoop() {
+    std::vector<PendingRequest> batch;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this] { return !queue_.empty() || !running_; });
+            if (queue_.empty()) {
+                return; // 已停止且队列为空
+            }
+
+            // 从第一个请求到达起最多等待 max_wait_ms，或凑满 max_batch_size
+            auto deadline = queue_.front().arrival + std::chrono::milliseconds(config_.max_wait_ms);
+            while (running_ && queue_.size() < config_.max_batch_size &&
+                   std::chrono::steady_clock::now() < deadline) {
+                queue_cv_.wait_until(lock, deadline);
+            }
+
+            size_t count = std::min(queue_.size(), config_.max_batch_size);
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+
+        try {
+            processBatch(batch);
+        } catch (...) {
+            // 检测或特征提取抛出异常时，批处理线程继续运行，尚未应答的请求由连接线程回复错误
+            std::cerr << "[RecognitionServer] 错误：批处理异常，" << batch.size() << " 个请求返回错误" << std::endl;
+            for (auto& request : batch) {
+                if (!request.answered) {
+                    request.result.set_exception(std::current_exception());
+                }
+            }
+        }
+        batch.clear();
+    }
+}
+
+void RecognitionServer::processBatch(std::vector<PendingRequest>& batch) {
+    TRACE_SPAN("processBatch");
+    // 1. 人脸检测（已裁剪的人脸直接使用整幅图像）
+    std::vector<std::vector<cv::Rect>> faces(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].type == REQUEST_FACE) {
+            faces[i].push_back(cv::Rect(0, 0, batch[i].image.cols, batch[i].image.rows));
+        } else {
+            faces[i] = ::detectFaces(batch[i].image);
+        }
+    }
+
+    // 2. 特征提取：整批请求的人脸合并为一次批量提取
+    std::vector<cv::Mat> crops;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const cv::Rect bounds(0, 0, batch[i].image.cols, batch[i].image.rows);
+        for (const auto& rect : faces[i]) {
+            crops.push_back(!rect.empty() && (rect & bounds) == rect ? batch[i].image(rect) : cv::Mat());
+        }
+    }
+    std::vector<cv::Mat> crop_features = engine_.extractFeatureBatch(crops);
+
+    // 3. 人脸匹配并返回结果（提取失败的人脸不参与匹配，结果为 Unknown）
+    RecognitionResults matched;
+    std::vector<cv::Rect> valid_faces;
+    std::vector<cv::Mat> valid_features;
+    size_t face_count = 0;
+    size_t crop_index = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        valid_faces.clear();
+        valid_features.clear();
+        for (size_t j = 0; j < faces[i].size(); ++j) {
+            const cv::Mat& feature = crop_features[crop_index + j];
+            if (!feature.empty()) {
+                valid_faces.push_back(faces[i][j]);
+                valid_features.push_back(feature);
+            }
+        }
+        matchFaces(valid_faces, valid_features, matched);
+
+        std::vector<FaceResult> results(faces[i].size());
+        size_t matched_index = 0;
+        for (size_t j = 0; j < faces[i].size(); ++j) {
+            results[j].rect = faces[i][j];
+            results[j].label_id = kUnknownLabel;
+            results[j].similarity = -1.0;
+            if (!crop_features[crop_index + j].empty()) {
+                results[j].label_id = matched[matched_index].label_id;
+                results[j].similarity = matched[matched_index].similarity;
+                matched_index++;
+            }
+        }
+        crop_index += faces[i].size();
+        face_count += results.size();
+
+        // 延迟包含匹配耗时：从请求到达到结果就绪
+        auto now = std::chrono::steady_clock::now();
+        recordLatency(std::chrono::duration<double, std::milli>(now - batch[i].arrival).count());
+        batch[i].result.set_value(std::move(results));
+        batch[i].answered = true;
+    }
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.requests += batch.size();
+    stats_.batches++;
+    stats_.faces += face_count;
+}
+
+void RecognitionServer::matchFaces(const std::vector<cv::Rect>& faces, const std::vector<cv::Mat>& features,
+                                   RecognitionResults& results) {
+    // 按ID匹配，不输出逐张人脸的日志
+    results.clear();
+    if (faces.empty()) {
+        return;
+    }
+    if (gallery_) {
+        engine_.matchFaces(faces, features, *gallery_, results);
+    } else if (shards_) {
+        engine_.matchFaces(faces, features, *shards_, results);
+    } else {
+        engine_.matchFaces(faces, features, *identities_, results);
+    }
+}
+
+void RecognitionServer::recordLatency(double latency_ms) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (latencies_.size() < kLatencyWindow) {
+        latencies_.push_back(latency_ms);
+    } else {
+        latencies_[latency_pos_] = latency_ms;
+        latency_pos_ = (latency_pos_ + 1) % kLatencyWindow;
+    }
+}
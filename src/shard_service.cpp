@@ -0,0 +1,437 @@
+#include "shard_service.h"
+#include "ipc.h"
+#include "label_table.h"
+#include "trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <poll.h>
+#include <queue>
+#include <sys/socket.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// 分片内的图库切片（归一化后连续存储）
+struct ShardSlice {
+    int dimension = 0;
+    std::vector<float> features;
+    std::vector<uint32_t> label_ids;
+};
+
+bool normalizeInto(const cv::Mat& mat, float* out, int dimension) {
+    cv::Mat f32;
+    mat.reshape(1, 1).convertTo(f32, CV_32F);
+    if (!f32.isContinuous()) {
+        f32 = f32.clone();
+    }
+    if ((int)f32.total() != dimension) {
+        return false;
+    }
+
+    const float* src = f32.ptr<float>(0);
+    double norm = 0.0;
+    for (int i = 0; i < dimension; ++i) {
+        norm += (double)src[i] * src[i];
+    }
+    norm = std::sqrt(norm);
+
+    // 避免除零
+    for (int i = 0; i < dimension; ++i) {
+        out[i] = norm < 1e-10 ? 0.0f : (float)(src[i] / norm);
+    }
+    return norm >= 1e-10;
+}
+
+// 在切片中查找 top_k（最小堆维护当前最好的 k 个）
+void searchSlice(const ShardSlice& slice, const float* query, size_t top_k,
+                 std::vector<std::pair<double, size_t>>& out) {
+    typedef std::pair<double, size_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+
+    const int dim = slice.dimension;
+    for (size_t i = 0; i < slice.label_ids.size(); ++i) {
+        const float* f = slice.features.data() + i * dim;
+        float sum = 0.0f;
+        for (int d = 0; d < dim; ++d) {
+            sum += query[d] * f[d];
+        }
+
+        if (heap.size() < top_k) {
+            heap.push({sum, i});
+        } else if (sum > heap.top().first) {
+            heap.pop();
+            heap.push({sum, i});
+        }
+    }
+
+    out.clear();
+    while (!heap.empty()) {
+        out.push_back(heap.top());
+        heap.pop();
+    }
+    std::reverse(out.begin(), out.end());
+}
+
+// 处理连接上的一个请求，连接关闭或请求无效时返回 false
+// 请求：[uint32 维度][维度个 float 归一化特征][uint32 top_k]
+// 响应：[uint32 数量] 数量 × ([double 相似度][uint32 标签ID])
+bool serveRequest(int conn, const ShardSlice& slice, std::vector<uint8_t>& request,
+                  std::vector<float>& query, std::vector<std::pair<double, size_t>>& top) {
+    if (!ipc::recvMessage(conn, request)) {
+        return false;
+    }
+    ipc::Reader reader(request);
+    uint32_t dim = reader.getU32();
+    if (!reader.ok() || dim != (uint32_t)slice.dimension ||
+        !reader.getBytes(query.data(), dim * sizeof(float))) {
+        return false;
+    }
+    uint32_t top_k = std::max<uint32_t>(1, reader.getU32());
+    if (!reader.ok()) {
+        return false;
+    }
+
+    searchSlice(slice, query.data(), top_k, top);
+
+    ipc::Writer writer;
+    writer.putU32((uint32_t)top.size());
+    for (const auto& entry : top) {
+        writer.putF64(entry.first);
+        writer.putU32(slice.label_ids[entry.second]);
+    }
+    return ipc::sendMessage(conn, writer.buffer());
+}
+
+// 工作进程主循环：协调器的每个并发查询各用一条连接，poll 同时监听新连接与所有已有连接，
+// 一条连接空闲时不会挡住其他连接上的请求
+void runShardWorker(int listen_fd, const ShardSlice& slice) {
+    std::vector<uint8_t> request;
+    std::vector<float> query(slice.dimension);
+    std::vector<std::pair<double, size_t>> top;
+    std::vector<pollfd> fds = {{listen_fd, POLLIN, 0}};
+
+    while (true) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "[ShardWorker] 错误：poll 失败: " << std::strerror(errno) << std::endl;
+            _exit(1);
+        }
+
+        // 从后往前处理已有连接，便于删除已关闭的连接
+        for (size_t i = fds.size() - 1; i >= 1; --i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if (!(fds[i].revents & POLLIN) || !serveRequest(fds[i].fd, slice, request, query, top)) {
+                ipc::closeSocket(fds[i].fd);
+                fds.erase(fds.begin() + i);
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int conn = accept(listen_fd, nullptr, nullptr);
+            if (conn < 0) {
+                // 只忽略暂时性错误；其他错误（如 EMFILE、EBADF）会持续出现，重试只会空转，直接退出
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                std::cerr << "[ShardWorker] 错误：accept 失败: " << std::strerror(errno) << std::endl;
+                _exit(1);
+            }
+            fds.push_back({conn, POLLIN, 0});
+        }
+    }
+}
+
+} // namespace
+
+ShardCoordinator::ShardCoordinator() : generation_(0), timeout_ms_(200), dimension_(0) {
+}
+
+ShardCoordinator::~ShardCoordinator() {
+    stop();
+}
+
+bool ShardCoordinator::start(const std::vector<cv::Mat>& features,
+                             const std::vector<std::string>& labels,
+                             int shard_count) {
+    stop();
+
+    if (features.empty() || features.size() != labels.size() || shard_count <= 0) {
+        std::cerr << "[ShardCoordinator] 错误：图库为空或分片数量无效" << std::endl;
+        return false;
+    }
+    shard_count = std::min<int>(shard_count, (int)features.size());
+    dimension_ = (int)features[0].total();
+
+    // 标签只在启动时驻留一次，之后协调器与工作进程之间只传递标签ID
+    std::vector<uint32_t> label_ids(labels.size());
+    for (size_t i = 0; i < labels.size(); ++i) {
+        label_ids[i] = LabelTable::global().intern(labels[i]);
+    }
+
+    for (int s = 0; s < shard_count; ++s) {
+        // 1. 轮询划分图库切片
+        ShardSlice slice;
+        slice.dimension = dimension_;
+        for (size_t i = s; i < features.size(); i += shard_count) {
+            slice.features.resize((slice.label_ids.size() + 1) * dimension_);
+            normalizeInto(features[i], slice.features.data() + slice.label_ids.size() * dimension_, dimension_);
+            slice.label_ids.push_back(label_ids[i]);
+        }
+
+        // 2. 在父进程中创建监听套接字，避免子进程启动前连接失败
+        Shard shard;
+        shard.socket_path = "/tmp/sfr_shard_" + std::to_string(getpid()) + "_" + std::to_string(s) + ".sock";
+        shard.lost = false;
+        shard.size = slice.label_ids.size();
+
+        int listen_fd = ipc::listenUnix(shard.socket_path);
+        if (listen_fd < 0) {
+            stop();
+            return false;
+        }
+
+        // 3. 启动工作进程
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "[ShardCoordinator] 错误：无法创建工作进程" << std::endl;
+            ipc::closeSocket(listen_fd);
+            stop();
+            return false;
+        }
+        if (pid == 0) {
+            // 父进程退出时工作进程随之退出
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            // 关闭继承的其他分片连接，否则父进程断开时对端无法感知
+            for (auto& other : shards_) {
+                closeIdleConnections(other);
+            }
+            runShardWorker(listen_fd, slice);
+            _exit(0);
+        }
+
+        ipc::closeSocket(listen_fd);
+        shard.pid = pid;
+        shards_.push_back(shard);
+
+        // 先建立一条连接，确认工作进程已可用
+        int fd = checkoutConnection(shards_.back());
+        if (fd >= 0) {
+            shards_.back().idle_fds.push_back(fd);
+        } else {
+            std::cerr << "[ShardCoordinator] 错误：无法连接分片 " << s << std::endl;
+            stop();
+            return false;
+        }
+    }
+
+    stats_ = ShardStats();
+    std::cout << "[ShardCoordinator] 启动 " << shards_.size() << " 个分片，共 "
+              << features.size() << " 个身份" << std::endl;
+    return true;
+}
+
+void ShardCoordinator::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 正在进行的查询持有的连接在归还时按 generation_ 关闭
+    generation_++;
+    for (auto& shard : shards_) {
+        closeIdleConnections(shard);
+        if (shard.pid > 0) {
+            kill(shard.pid, SIGTERM);
+            waitpid(shard.pid, nullptr, 0);
+        }
+        ::unlink(shard.socket_path.c_str());
+    }
+    shards_.clear();
+}
+
+bool ShardCoordinator::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !shards_.empty();
+}
+
+int ShardCoordinator::shardCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int)shards_.size();
+}
+
+void ShardCoordinator::setTimeoutMs(int timeout_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeout_ms_ = timeout_ms;
+}
+
+bool ShardCoordinator::query(const cv::Mat& features, size_t top_k, std::vector<ShardMatch>& matches) {
+    TRACE_SPAN("shardQuery");
+    matches.clear();
+
+    std::vector<float> query(dimension_);
+    if (features.empty() || (int)features.total() != dimension_ ||
+        !normalizeInto(features, query.data(), dimension_)) {
+        return false;
+    }
+
+    // 1. 加锁只为从每个分片取出一条连接，收发期间不持有锁，并发查询各用自己的连接
+    std::vector<int> fds;
+    uint64_t generation;
+    int timeout_ms;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shards_.empty()) {
+            return false;
+        }
+        stats_.queries++;
+        generation = generation_;
+        timeout_ms = timeout_ms_;
+        fds.resize(shards_.size());
+        for (size_t s = 0; s < shards_.size(); ++s) {
+            fds[s] = checkoutConnection(shards_[s]);
+            if (fds[s] < 0) {
+                stats_.failures++;
+            }
+        }
+    }
+
+    ipc::Writer writer;
+    writer.putU32((uint32_t)dimension_);
+    writer.putBytes(query.data(), query.size() * sizeof(float));
+    writer.putU32((uint32_t)std::max<size_t>(1, top_k));
+
+    // 2. Scatter：先向所有分片发送请求，各分片并行计算
+    // 失败或超时的连接直接关闭（超时后的残留响应会打乱协议），不归还
+    std::vector<bool> lost(fds.size(), false);
+    uint64_t failures = 0;
+    uint64_t timeouts = 0;
+    for (size_t s = 0; s < fds.size(); ++s) {
+        if (fds[s] >= 0 && !ipc::sendMessage(fds[s], writer.buffer())) {
+            failures++;
+            ipc::closeSocket(fds[s]);
+            fds[s] = -1;
+            lost[s] = true;
+        }
+    }
+
+    // 3. Gather：在统一的截止时间内收集各分片结果
+    using clock = std::chrono::steady_clock;
+    auto deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+    size_t responded = 0;
+    std::vector<uint8_t> response;
+
+    for (size_t s = 0; s < fds.size(); ++s) {
+        if (fds[s] < 0) {
+            continue;
+        }
+
+        int remaining = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - clock::now()).count();
+        if (!ipc::recvMessage(fds[s], response, std::max(0, remaining))) {
+            timeouts++;
+            std::cerr << "[ShardCoordinator] 分片 " << s << " 超时或失败" << std::endl;
+            ipc::closeSocket(fds[s]);
+            fds[s] = -1;
+            lost[s] = true;
+            continue;
+        }
+
+        ipc::Reader reader(response);
+        uint32_t count = reader.getU32();
+        for (uint32_t i = 0; i < count && reader.ok(); ++i) {
+            ShardMatch match;
+            match.similarity = reader.getF64();
+            match.label_id = reader.getU32();
+            match.shard = (int)s;
+            if (reader.ok()) {
+                matches.push_back(match);
+            }
+        }
+        responded++;
+    }
+
+    // 4. 归还连接并汇总统计；期间分片被停止或重建时关闭连接
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.failures += failures;
+        stats_.timeouts += timeouts;
+        if (responded < fds.size()) {
+            stats_.partial++;
+        }
+        bool current = generation == generation_;
+        for (size_t s = 0; s < fds.size(); ++s) {
+            if (!current) {
+                ipc::closeSocket(fds[s]);
+            } else if (fds[s] >= 0) {
+                shards_[s].idle_fds.push_back(fds[s]);
+            } else if (lost[s]) {
+                shards_[s].lost = true;
+            }
+        }
+    }
+
+    // 5. 合并各分片的 top-k
+    size_t keep = std::min(top_k, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + keep, matches.end(),
+                      [](const ShardMatch& a, const ShardMatch& b) {
+                          return a.similarity > b.similarity;
+                      });
+    matches.resize(keep);
+
+    return responded > 0;
+}
+
+ShardStats ShardCoordinator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ShardCoordinator::printStats() const {
+    ShardStats stats = getStats();
+    std::cout << "[ShardCoordinator] 分片: " << shardCount()
+              << ", 查询: " << stats.queries
+              << ", 部分结果: " << stats.partial
+              << ", 超时: " << stats.timeouts
+              << ", 失败: " << stats.failures
+              << ", 重连: " << stats.reconnects << std::endl;
+}
+
+int ShardCoordinator::checkoutConnection(Shard& shard) {
+    if (!shard.idle_fds.empty()) {
+        int fd = shard.idle_fds.back();
+        shard.idle_fds.pop_back();
+        return fd;
+    }
+
+    // 检查工作进程是否仍然存活
+    if (shard.pid > 0 && waitpid(shard.pid, nullptr, WNOHANG) == shard.pid) {
+        std::cerr << "[ShardCoordinator] 工作进程已退出: " << shard.pid << std::endl;
+        shard.pid = -1;
+    }
+    if (shard.pid <= 0) {
+        return -1;
+    }
+
+    int fd = ipc::connectUnix(shard.socket_path);
+    if (fd >= 0 && shard.lost) {
+        stats_.reconnects++;
+        shard.lost = false;
+    }
+    return fd;
+}
+
+void ShardCoordinator::closeIdleConnections(Shard& shard) {
+    for (int fd : shard.idle_fds) {
+        ipc::closeSocket(fd);
+    }
+    shard.idle_fds.clear();
+}
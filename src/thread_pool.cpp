@@ -0,0 +1,292 @@
+#include "thread_pool.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <dirent.h>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// 当前线程所属的线程池（非工作线程为空）
+thread_local const ThreadPool* t_current_pool = nullptr;
+
+// 解析 cpulist 格式，例如 "0-3,8-11"
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            continue;
+        }
+    }
+    return cpus;
+}
+
+// parallelFor 的共享状态：迟到的辅助任务只访问该状态，不会访问已返回的调用者栈
+struct ParallelForState {
+    size_t count = 0;
+    const std::function<void(size_t)>* body = nullptr;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    std::exception_ptr error;
+
+    // 循环领取下标直到全部分配完
+    void run() {
+        size_t finished = 0;
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                (*body)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            finished++;
+        }
+        if (finished > 0 && done.fetch_add(finished) + finished == count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done_cv.notify_all();
+        }
+    }
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t num_threads) : busy_(0), stopping_(false), affinity_(AffinityMode::NONE) {
+    start(num_threads);
+}
+
+ThreadPool::ThreadPool(const ThreadPoolOptions& options)
+    : busy_(0), stopping_(false), affinity_(options.affinity) {
+    start(options.num_threads);
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+void ThreadPool::start(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max<size_t>(1, availableCpus().size());
+    }
+
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            std::cerr << "[ThreadPool] 错误：线程池已停止，任务被丢弃" << std::endl;
+            return;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    task_cv_.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || workers_.size() <= 1 || isWorkerThread()) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>();
+    state->count = count;
+    state->body = &body;
+
+    // 调用线程自己承担一份，其余交给工作线程
+    size_t helpers = std::min(count, workers_.size() + 1) - 1;
+    for (size_t h = 0; h < helpers; ++h) {
+        enqueue([state]() { state->run(); });
+    }
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done_cv.wait(lock, [&state] { return state->done.load() == state->count; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+bool ThreadPool::isWorkerThread() const {
+    return t_current_pool == this;
+}
+
+void ThreadPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] { return tasks_.empty() && busy_ == 0; });
+}
+
+void ThreadPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    task_cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers_.size();
+}
+
+std::vector<int> ThreadPool::availableCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            cpus.push_back((int)cpu);
+        }
+    }
+    return cpus;
+}
+
+std::vector<std::vector<int>> ThreadPool::numaNodes() {
+    std::vector<int> available = availableCpus();
+    std::vector<std::vector<int>> nodes;
+
+    const std::string root = "/sys/devices/system/node";
+    DIR* dir = opendir(root.c_str());
+    if (dir) {
+        std::vector<int> node_ids;
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") == 0 && name.size() > 4 &&
+                std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+                node_ids.push_back(std::stoi(name.substr(4)));
+            }
+        }
+        closedir(dir);
+        std::sort(node_ids.begin(), node_ids.end());
+
+        for (int id : node_ids) {
+            std::ifstream in(root + "/node" + std::to_string(id) + "/cpulist");
+            std::string text;
+            std::getline(in, text);
+
+            // 只保留当前进程允许使用的CPU
+            std::vector<int> cpus;
+            for (int cpu : parseCpuList(text)) {
+                if (std::find(available.begin(), available.end(), cpu) != available.end()) {
+                    cpus.push_back(cpu);
+                }
+            }
+            if (!cpus.empty()) {
+                nodes.push_back(cpus);
+            }
+        }
+    }
+
+    if (nodes.empty()) {
+        nodes.push_back(available);
+    }
+    return nodes;
+}
+
+void ThreadPool::pinWorker(size_t index) {
+    if (affinity_ == AffinityMode::NONE) {
+        return;
+    }
+
+    std::vector<int> cpus;
+    if (affinity_ == AffinityMode::CORE) {
+        std::vector<int> available = availableCpus();
+        cpus.push_back(available[index % available.size()]);
+    } else {
+        std::vector<std::vector<int>> nodes = numaNodes();
+        cpus = nodes[index % nodes.size()];
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "[ThreadPool] 警告：工作线程 " << index << " 绑定CPU失败 (错误码 " << rc << ")" << std::endl;
+    }
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    t_current_pool = this;
+    pinWorker(index);
+    trace::setThreadName("ThreadPool-" + std::to_string(index));
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return; // 已停止且队列为空
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            busy_++;
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "[ThreadPool] 任务异常: " << e.what() << std::endl;
+        } catch (...) {
+            // 非 std::exception 的异常同样不能让工作线程退出（否则 busy_ 无法归零，等待空闲的调用者会一直阻塞）
+            std::cerr << "[ThreadPool] 任务异常: 未知异常" << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_--;
+            if (tasks_.empty() && busy_ == 0) {
+                idle_cv_.notify_all();
+            }
+        }
+    }
+}
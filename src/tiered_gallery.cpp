@@ -0,0 +1,453 @@
+#include "tiered_gallery.h"
+#include "label_table.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// 冷层文件格式：
+//   [文件头，填充到一页] [count * dim 个归一化float特征] [count+1 个uint64标签偏移] [标签字节]
+const char kColdStoreMagic[8] = {'S', 'F', 'R', 'G', 'A', 'L', '0', '1'};
+const uint32_t kColdStoreVersion = 1;
+const size_t kPageSize = 4096;
+
+struct ColdStoreHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dimension;
+    uint64_t count;
+    uint64_t features_offset;
+    uint64_t labels_offset;
+};
+
+// 特征维度上限（防止损坏的文件头导致越界读取或巨大的分配）
+const uint32_t kMaxDimension = 1 << 16;
+
+// 校验文件头描述的各区域都在映射范围内：特征区位于文件头之后、标签偏移表之前，
+// 标签偏移表位于文件内（按除法比较，避免 count * dimension 溢出）
+bool validHeader(const ColdStoreHeader& header, size_t mapping_size) {
+    if (std::memcmp(header.magic, kColdStoreMagic, sizeof(header.magic)) != 0 ||
+        header.version != kColdStoreVersion || header.dimension == 0 || header.dimension > kMaxDimension) {
+        return false;
+    }
+    if (header.features_offset < kPageSize || header.features_offset > header.labels_offset ||
+        header.labels_offset > mapping_size) {
+        return false;
+    }
+    const uint64_t record_bytes = (uint64_t)header.dimension * sizeof(float);
+    if (header.count > (header.labels_offset - header.features_offset) / record_bytes) {
+        return false;
+    }
+    return header.count < (mapping_size - header.labels_offset) / sizeof(uint64_t);
+}
+
+// 热层直接接受阈值的默认值：大于1表示关闭捷径，每次查询都扫描冷层，结果为精确最佳匹配
+const double kExactMatch = 2.0;
+
+// 每个热层条目的额外开销估计（链表与哈希节点）
+const size_t kHotEntryOverhead = 128;
+
+// 将Mat特征转换为归一化的float向量（out 复用已有容量；连续的 CV_32F 特征不做类型转换）
+bool toNormalizedVector(const cv::Mat& mat, std::vector<float>& out) {
+    if (mat.type() == CV_32F && mat.isContinuous()) {
+        const float* src = mat.ptr<float>(0);
+        out.assign(src, src + mat.total());
+    } else {
+        cv::Mat flat = mat.reshape(1, 1);
+        cv::Mat f32;
+        flat.convertTo(f32, CV_32F);
+        if (!f32.isContinuous()) {
+            f32 = f32.clone();
+        }
+        const float* src = f32.ptr<float>(0);
+        out.assign(src, src + f32.cols);
+    }
+
+    double norm = 0.0;
+    for (float v : out) {
+        norm += (double)v * v;
+    }
+    norm = std::sqrt(norm);
+
+    // 避免除零
+    if (norm < 1e-10) {
+        return false;
+    }
+    for (float& v : out) {
+        v = (float)(v / norm);
+    }
+    return true;
+}
+
+inline double dot(const float* a, const float* b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+} // namespace
+
+double TieredGalleryStats::hotHitRate() const {
+    return lookups > 0 ? (double)hot_hits / lookups : 0.0;
+}
+
+double TieredGalleryStats::coldHitRate() const {
+    return lookups > 0 ? (double)cold_hits / lookups : 0.0;
+}
+
+TieredGallery::TieredGallery()
+    : fd_(-1), mapping_(nullptr), mapping_size_(0),
+      dimension_(0), count_(0), features_offset_(0), labels_offset_(0),
+      memory_budget_(0), hot_capacity_(0), scan_window_bytes_(0),
+      hot_accept_similarity_(kExactMatch) {
+}
+
+TieredGallery::~TieredGallery() {
+    close();
+}
+
+bool TieredGallery::writeColdStore(const std::string& path,
+                                   const std::vector<cv::Mat>& features,
+                                   const std::vector<std::string>& labels) {
+    if (features.empty() || features.size() != labels.size()) {
+        std::cerr << "[TieredGallery] 错误：特征与标签数量不匹配或为空" << std::endl;
+        return false;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "[TieredGallery] 错误：无法创建冷层文件: " << path << std::endl;
+        return false;
+    }
+
+    const uint32_t dim = (uint32_t)features[0].total();
+
+    ColdStoreHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kColdStoreMagic, sizeof(header.magic));
+    header.version = kColdStoreVersion;
+    header.dimension = dim;
+    header.count = features.size();
+    header.features_offset = kPageSize;
+    header.labels_offset = kPageSize + (uint64_t)features.size() * dim * sizeof(float);
+
+    std::vector<char> header_page(kPageSize, 0);
+    std::memcpy(header_page.data(), &header, sizeof(header));
+    out.write(header_page.data(), header_page.size());
+
+    // 写入归一化特征
+    std::vector<float> normalized;
+    for (size_t i = 0; i < features.size(); ++i) {
+        if (features[i].total() != dim) {
+            std::cerr << "[TieredGallery] 错误：特征维度不一致: " << labels[i] << std::endl;
+            return false;
+        }
+        if (!toNormalizedVector(features[i], normalized)) {
+            normalized.assign(dim, 0.0f);
+        }
+        out.write(reinterpret_cast<const char*>(normalized.data()), dim * sizeof(float));
+    }
+
+    // 写入标签偏移表和标签内容
+    std::vector<uint64_t> offsets(labels.size() + 1, 0);
+    for (size_t i = 0; i < labels.size(); ++i) {
+        offsets[i + 1] = offsets[i] + labels[i].size();
+    }
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    for (const auto& label : labels) {
+        out.write(label.data(), label.size());
+    }
+
+    if (!out) {
+        std::cerr << "[TieredGallery] 错误：写入冷层文件失败: " << path << std::endl;
+        return false;
+    }
+
+    std::cout << "[TieredGallery] 冷层文件已写入: " << path
+              << " (" << features.size() << " 个身份, " << dim << " 维)" << std::endl;
+    return true;
+}
+
+bool TieredGallery::open(const std::string& path, size_t memory_budget_bytes) {
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::cerr << "[TieredGallery] 错误：无法打开冷层文件: " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || (size_t)st.st_size < sizeof(ColdStoreHeader)) {
+        std::cerr << "[TieredGallery] 错误：冷层文件无效: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    mapping_size_ = (size_t)st.st_size;
+    void* addr = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        std::cerr << "[TieredGallery] 错误：内存映射失败: " << path << std::endl;
+        mapping_size_ = 0;
+        close();
+        return false;
+    }
+    mapping_ = static_cast<uint8_t*>(addr);
+
+    ColdStoreHeader header;
+    std::memcpy(&header, mapping_, sizeof(header));
+    if (!validHeader(header, mapping_size_)) {
+        std::cerr << "[TieredGallery] 错误：冷层文件格式不正确: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    dimension_ = header.dimension;
+    count_ = header.count;
+    features_offset_ = header.features_offset;
+    labels_offset_ = header.labels_offset;
+
+    // 冷层按顺序扫描，热层由LRU管理
+    madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+
+    // 内存预算：四分之一（最多4MB）用作冷层扫描窗口，其余用于热层
+    memory_budget_ = memory_budget_bytes;
+    scan_window_bytes_ = std::min<size_t>(memory_budget_ / 4, 4 * 1024 * 1024);
+    scan_window_bytes_ = std::max(kPageSize, scan_window_bytes_ / kPageSize * kPageSize);
+    size_t entry_bytes = dimension_ * sizeof(float) + kHotEntryOverhead;
+    size_t hot_budget = memory_budget_ > scan_window_bytes_ ? memory_budget_ - scan_window_bytes_ : 0;
+    hot_capacity_ = std::max<size_t>(1, hot_budget / entry_bytes);
+
+    stats_ = TieredGalleryStats();
+    stats_.cold_count = count_;
+    stats_.hot_capacity = hot_capacity_;
+    stats_.memory_budget = memory_budget_;
+
+    std::cout << "[TieredGallery] 打开冷层文件: " << path << " (" << count_ << " 个身份, "
+              << dimension_ << " 维), 热层容量: " << hot_capacity_
+              << ", 扫描窗口: " << scan_window_bytes_ / 1024 << " KB" << std::endl;
+    return true;
+}
+
+void TieredGallery::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    mapping_size_ = 0;
+    count_ = 0;
+    hot_.clear();
+    lru_.clear();
+}
+
+bool TieredGallery::isOpen() const {
+    return mapping_ != nullptr;
+}
+
+size_t TieredGallery::size() const {
+    return count_;
+}
+
+int TieredGallery::dimension() const {
+    return (int)dimension_;
+}
+
+void TieredGallery::setHotAcceptSimilarity(double similarity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hot_accept_similarity_ = similarity;
+}
+
+cv::Mat TieredGallery::getFeature(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!mapping_ || index >= count_) {
+        return cv::Mat();
+    }
+
+    HotEntry& entry = touch(index);
+    return cv::Mat(1, (int)dimension_, CV_32F, entry.feature.data()).clone();
+}
+
+std::string TieredGallery::getLabel(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!mapping_ || index >= count_) {
+        return std::string();
+    }
+    return readLabel(index);
+}
+
+bool TieredGallery::readAll(std::vector<float>& features, std::vector<std::string>& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!mapping_) {
+        return false;
+    }
+
+    const size_t record_bytes = dimension_ * sizeof(float);
+    const size_t records_per_window = std::max<size_t>(1, scan_window_bytes_ / record_bytes);
+    features.resize(count_ * dimension_);
+    labels.resize(count_);
+
+    for (size_t start = 0; start < count_; start += records_per_window) {
+        size_t end = std::min<size_t>(count_, start + records_per_window);
+        std::memcpy(features.data() + start * dimension_, coldFeature(start), (end - start) * record_bytes);
+
+        size_t aligned_begin = (features_offset_ + start * record_bytes) / kPageSize * kPageSize;
+        size_t aligned_end = (features_offset_ + end * record_bytes) / kPageSize * kPageSize;
+        if (aligned_end > aligned_begin) {
+            madvise(mapping_ + aligned_begin, aligned_end - aligned_begin, MADV_DONTNEED);
+        }
+        stats_.cold_bytes_scanned += (end - start) * record_bytes;
+    }
+
+    for (size_t i = 0; i < count_; ++i) {
+        labels[i] = readLabel(i);
+    }
+    return true;
+}
+
+bool TieredGallery::findBestMatch(const cv::Mat& query,
+                                  size_t& best_index,
+                                  uint32_t& best_label_id,
+                                  double& best_similarity) {
+    TRACE_SPAN("galleryMatch");
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!mapping_ || count_ == 0) {
+        return false;
+    }
+
+    // 查询向量写入复用的缓冲区，每次查询不再分配
+    std::vector<float>& q = query_buffer_;
+    if (query.empty() || query.total() != dimension_ || !toNormalizedVector(query, q)) {
+        return false;
+    }
+
+    stats_.lookups++;
+    best_similarity = -1.0;
+    best_index = 0;
+
+    // 1. 扫描热层
+    for (const auto& item : hot_) {
+        double similarity = dot(q.data(), item.second.feature.data(), dimension_);
+        if (similarity > best_similarity) {
+            best_similarity = similarity;
+            best_index = item.first;
+        }
+    }
+
+    if (!hot_.empty() && best_similarity >= hot_accept_similarity_) {
+        stats_.hot_hits++;
+    } else {
+        // 2. 热层未能确定结果，扫描冷层
+        stats_.cold_hits++;
+        scanCold(q, best_index, best_similarity);
+    }
+
+    // 3. 将最佳匹配换入（或保持在）热层，标签ID在换入时驻留，命中热层时不再读取标签
+    HotEntry& entry = touch(best_index);
+    best_label_id = entry.label_id;
+    return true;
+}
+
+TieredGalleryStats TieredGallery::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TieredGalleryStats stats = stats_;
+    stats.hot_count = hot_.size();
+    return stats;
+}
+
+void TieredGallery::printStats() const {
+    TieredGalleryStats stats = getStats();
+    std::cout << "[TieredGallery] 查询: " << stats.lookups
+              << ", 热层命中率: " << std::fixed << std::setprecision(3) << stats.hotHitRate()
+              << ", 冷层命中率: " << stats.coldHitRate()
+              << ", 换入: " << stats.page_ins
+              << ", 淘汰: " << stats.evictions
+              << ", 热层: " << stats.hot_count << "/" << stats.hot_capacity
+              << ", 冷层扫描: " << stats.cold_bytes_scanned / (1024 * 1024) << " MB" << std::endl;
+}
+
+const float* TieredGallery::coldFeature(size_t index) const {
+    return reinterpret_cast<const float*>(mapping_ + features_offset_) + index * dimension_;
+}
+
+std::string TieredGallery::readLabel(size_t index) const {
+    const uint8_t* table = mapping_ + labels_offset_;
+    uint64_t begin, end;
+    std::memcpy(&begin, table + index * sizeof(uint64_t), sizeof(uint64_t));
+    std::memcpy(&end, table + (index + 1) * sizeof(uint64_t), sizeof(uint64_t));
+
+    // 偏移来自文件内容，按减法比较，损坏文件中的巨大偏移不会使加法溢出
+    size_t data_offset = labels_offset_ + (count_ + 1) * sizeof(uint64_t);
+    if (end < begin || data_offset > mapping_size_ || end > mapping_size_ - data_offset) {
+        return std::string();
+    }
+    return std::string(reinterpret_cast<const char*>(mapping_ + data_offset + begin), end - begin);
+}
+
+TieredGallery::HotEntry& TieredGallery::touch(size_t index) {
+    auto it = hot_.find(index);
+    if (it != hot_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+        return it->second;
+    }
+
+    // 热层已满，淘汰最久未使用的身份
+    while (hot_.size() >= hot_capacity_ && !lru_.empty()) {
+        hot_.erase(lru_.back());
+        lru_.pop_back();
+        stats_.evictions++;
+    }
+
+    const float* src = coldFeature(index);
+    HotEntry& entry = hot_[index];
+    entry.feature.assign(src, src + dimension_);
+    entry.label_id = LabelTable::global().intern(readLabel(index));
+    lru_.push_front(index);
+    entry.lru_pos = lru_.begin();
+    stats_.page_ins++;
+    return entry;
+}
+
+void TieredGallery::scanCold(const std::vector<float>& query, size_t& best_index, double& best_similarity) {
+    const size_t record_bytes = dimension_ * sizeof(float);
+    const size_t records_per_window = std::max<size_t>(1, scan_window_bytes_ / record_bytes);
+
+    for (size_t start = 0; start < count_; start += records_per_window) {
+        size_t end = std::min<size_t>(count_, start + records_per_window);
+
+        for (size_t i = start; i < end; ++i) {
+            double similarity = dot(query.data(), coldFeature(i), dimension_);
+            if (similarity > best_similarity) {
+                best_similarity = similarity;
+                best_index = i;
+            }
+        }
+
+        // 释放已扫描窗口的页面，保持常驻内存可预测
+        size_t begin_byte = features_offset_ + start * record_bytes;
+        size_t end_byte = features_offset_ + end * record_bytes;
+        size_t aligned_begin = begin_byte / kPageSize * kPageSize;
+        size_t aligned_end = end_byte / kPageSize * kPageSize;
+        if (aligned_end > aligned_begin) {
+            madvise(mapping_ + aligned_begin, aligned_end - aligned_begin, MADV_DONTNEED);
+        }
+        stats_.cold_bytes_scanned += (end - start) * record_bytes;
+    }
+}
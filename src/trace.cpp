@@ -0,0 +1,173 @@
+#include "trace.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace trace {
+
+std::atomic<bool> g_enabled(false);
+
+namespace {
+
+// 每个线程最多保留的事件数，超出后丢弃新事件
+const size_t kMaxEventsPerThread = 1 << 20;
+
+struct Event {
+    const char* name;
+    int64_t start_us;
+    int64_t duration_us;
+};
+
+// 单个线程的事件缓冲区；线程退出后仍由注册表持有，导出时不会丢失
+struct ThreadBuffer {
+    int tid = 0;
+    std::string name;
+    std::mutex mutex;          // 只在导出或清空时与写入线程竞争
+    std::vector<Event> events;
+    uint64_t dropped = 0;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+// 时间原点（steady_clock 微秒），start() 时重置
+std::atomic<int64_t> g_origin_us(0);
+
+int64_t steadyUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+ThreadBuffer& threadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->tid = (int)syscall(SYS_gettid);
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// JSON 字符串转义
+std::string escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+void start() {
+    Registry& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (auto& buffer : reg.buffers) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            buffer->events.clear();
+            buffer->dropped = 0;
+        }
+        g_origin_us.store(steadyUs());
+    }
+    g_enabled.store(true, std::memory_order_relaxed);
+    std::cout << "[Trace] 开始追踪" << std::endl;
+}
+
+void stop() {
+    g_enabled.store(false, std::memory_order_relaxed);
+}
+
+void setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+int64_t Span::nowUs() {
+    return steadyUs() - g_origin_us.load(std::memory_order_relaxed);
+}
+
+void Span::record(const char* name, int64_t start_us, int64_t duration_us) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= kMaxEventsPerThread) {
+        buffer.dropped++;
+        return;
+    }
+    buffer.events.push_back(Event{name, start_us, duration_us});
+}
+
+size_t eventCount() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t count = 0;
+    for (auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        count += buffer->events.size();
+    }
+    return count;
+}
+
+bool dumpJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "[Trace] 错误：无法写入追踪文件: " << path << std::endl;
+        return false;
+    }
+
+    int pid = (int)getpid();
+    size_t count = 0;
+    uint64_t dropped = 0;
+    bool first = true;
+    auto separator = [&]() -> const char* {
+        const char* sep = first ? "\n" : ",\n";
+        first = false;
+        return sep;
+    };
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        if (!buffer->name.empty()) {
+            out << separator() << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+                << ", \"tid\": " << buffer->tid << ", \"args\": {\"name\": \"" << escape(buffer->name) << "\"}}";
+        }
+        for (const Event& event : buffer->events) {
+            out << separator() << "{\"name\": \"" << escape(event.name) << "\", \"cat\": \"pipeline\", \"ph\": \"X\""
+                << ", \"ts\": " << event.start_us << ", \"dur\": " << event.duration_us
+                << ", \"pid\": " << pid << ", \"tid\": " << buffer->tid << "}";
+        }
+        count += buffer->events.size();
+        dropped += buffer->dropped;
+    }
+    out << "\n]}\n";
+
+    std::cout << "[Trace] 已导出 " << count << " 个事件到 " << path;
+    if (dropped > 0) {
+        std::cout << " (缓冲区已满，丢弃 " << dropped << " 个)";
+    }
+    std::cout << std::endl;
+    return out.good();
+}
+
+} // namespace trace
@@ -3,12 +3,16 @@
 #include <opencv2/core.hpp>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
 
 namespace fs = std::filesystem;
 
 namespace utils {
 
-std::string getProjectRoot() {
+namespace {
+
+std::string findProjectRoot() {
     // 获取当前工作目录
     fs::path currentPath = fs::current_path();
     
@@ -53,7 +57,7 @@ std::string getProjectRoot() {
     return currentPath.string();
 }
 
-std::string getModelPath(const std::string& modelName) {
+std::string findModelPath(const std::string& modelName) {
     std::string projectRoot = getProjectRoot();
     
     // 使用filesystem::path进行跨平台路径拼接
@@ -84,7 +88,7 @@ std::string getModelPath(const std::string& modelName) {
     return modelPath.string();
 }
 
-std::string getPicturesDirectory() {
+std::string findPicturesDirectory() {
     std::string projectRoot = getProjectRoot();
     
     // 使用filesystem::path进行跨平台路径拼接
@@ -115,6 +119,31 @@ std::string getPicturesDirectory() {
     return picturesPath.string();
 }
 
+} // namespace
+
+// 路径只在首次调用时探测一次（运行期间工作目录不变），之后直接返回缓存结果
+std::string getProjectRoot() {
+    static const std::string root = findProjectRoot();
+    return root;
+}
+
+std::string getModelPath(const std::string& modelName) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::string> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(modelName);
+    if (it == cache.end()) {
+        it = cache.emplace(modelName, findModelPath(modelName)).first;
+    }
+    return it->second;
+}
+
+std::string getPicturesDirectory() {
+    static const std::string directory = findPicturesDirectory();
+    return directory;
+}
+
 bool fileExists(const std::string& filePath) {
     return fs::exists(filePath);
 }
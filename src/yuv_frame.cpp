@@ -0,0 +1,110 @@
+#include "yuv_frame.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// 4:2:0 要求亮度平面宽高为偶数，色度平面为其一半
+bool validPlanes(const cv::Mat& y_plane, const cv::Size& chroma_size) {
+    return !y_plane.empty() && y_plane.type() == CV_8UC1 &&
+           y_plane.cols % 2 == 0 && y_plane.rows % 2 == 0 &&
+           chroma_size == cv::Size(y_plane.cols / 2, y_plane.rows / 2);
+}
+
+} // namespace
+
+YuvFrame YuvFrame::fromNV12(const cv::Mat& y_plane, const cv::Mat& uv_plane) {
+    if (!validPlanes(y_plane, uv_plane.size()) || uv_plane.type() != CV_8UC2) {
+        std::cerr << "[YuvFrame] 错误：NV12 平面尺寸或类型不符" << std::endl;
+        return YuvFrame();
+    }
+    YuvFrame frame;
+    frame.layout = YuvLayout::NV12;
+    frame.y = y_plane;
+    frame.uv = uv_plane;
+    return frame;
+}
+
+YuvFrame YuvFrame::fromI420(const cv::Mat& y_plane, const cv::Mat& u_plane, const cv::Mat& v_plane) {
+    if (!validPlanes(y_plane, u_plane.size()) || u_plane.size() != v_plane.size() ||
+        u_plane.type() != CV_8UC1 || v_plane.type() != CV_8UC1) {
+        std::cerr << "[YuvFrame] 错误：I420 平面尺寸或类型不符" << std::endl;
+        return YuvFrame();
+    }
+    YuvFrame frame;
+    frame.layout = YuvLayout::I420;
+    frame.y = y_plane;
+    frame.u = u_plane;
+    frame.v = v_plane;
+    return frame;
+}
+
+YuvFrame YuvFrame::wrap(const cv::Mat& buffer, YuvLayout layout) {
+    if (buffer.type() != CV_8UC1 || !buffer.isContinuous() || buffer.rows % 3 != 0) {
+        std::cerr << "[YuvFrame] 错误：YUV 缓冲区应为连续的 CV_8UC1，行数为高度的 3/2" << std::endl;
+        return YuvFrame();
+    }
+    return wrap(const_cast<uint8_t*>(buffer.ptr<uint8_t>()), buffer.cols, buffer.rows * 2 / 3, layout);
+}
+
+YuvFrame YuvFrame::wrap(uint8_t* data, int width, int height, YuvLayout layout, size_t stride) {
+    if (!data || width <= 0 || height <= 0 || width % 2 != 0 || height % 2 != 0) {
+        std::cerr << "[YuvFrame] 错误：YUV 帧尺寸必须为正偶数" << std::endl;
+        return YuvFrame();
+    }
+    if (stride == 0) {
+        stride = width;
+    }
+
+    cv::Mat y_plane(height, width, CV_8UC1, data, stride);
+    uint8_t* chroma = data + stride * height;
+    if (layout == YuvLayout::NV12) {
+        return fromNV12(y_plane, cv::Mat(height / 2, width / 2, CV_8UC2, chroma, stride));
+    }
+    size_t chroma_stride = stride / 2;
+    cv::Mat u_plane(height / 2, width / 2, CV_8UC1, chroma, chroma_stride);
+    cv::Mat v_plane(height / 2, width / 2, CV_8UC1, chroma + chroma_stride * (height / 2), chroma_stride);
+    return fromI420(y_plane, u_plane, v_plane);
+}
+
+bool yuvCropToBgr(const YuvFrame& frame, const cv::Rect& rect, cv::Mat& bgr) {
+    if (frame.empty() || rect.empty() || (rect & cv::Rect(0, 0, frame.width(), frame.height())) != rect) {
+        return false;
+    }
+
+    // 扩展到偶数坐标，使亮度区域与色度采样网格对齐
+    int x0 = rect.x & ~1;
+    int y0 = rect.y & ~1;
+    int x1 = std::min(frame.width(), (rect.x + rect.width + 1) & ~1);
+    int y1 = std::min(frame.height(), (rect.y + rect.height + 1) & ~1);
+    cv::Rect aligned(x0, y0, x1 - x0, y1 - y0);
+    cv::Rect chroma(x0 / 2, y0 / 2, aligned.width / 2, aligned.height / 2);
+
+    cv::Mat converted;
+    if (frame.layout == YuvLayout::NV12) {
+        // 两个平面的 ROI 直接转换，不复制
+        cv::cvtColorTwoPlane(frame.y(aligned), frame.uv(chroma), converted, cv::COLOR_YUV2BGR_NV12);
+    } else {
+        // I420 没有分平面的转换接口：把区域打包成 OpenCV 的单缓冲区布局（只复制裁剪区域）
+        thread_local cv::Mat packed;
+        packed.create(aligned.height * 3 / 2, aligned.width, CV_8UC1);
+        frame.y(aligned).copyTo(packed.rowRange(0, aligned.height));
+
+        uint8_t* dst = packed.ptr<uint8_t>(aligned.height);
+        for (const cv::Mat* plane : {&frame.u, &frame.v}) {
+            for (int row = 0; row < chroma.height; ++row) {
+                std::memcpy(dst, plane->ptr<uint8_t>(chroma.y + row) + chroma.x, chroma.width);
+                dst += chroma.width;
+            }
+        }
+        cv::cvtColor(packed, converted, cv::COLOR_YUV2BGR_I420);
+    }
+
+    bgr = aligned == rect ? converted : converted(cv::Rect(rect.x - x0, rect.y - y0, rect.width, rect.height));
+    return true;
+}
+
+bool yuvToBgr(const YuvFrame& frame, cv::Mat& bgr) {
+    return yuvCropToBgr(frame, cv::Rect(0, 0, frame.width(), frame.height()), bgr);
+}
@@ -0,0 +1,224 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "face_detection.h"
+#include "face_recognition.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 丢弃输出的流缓冲，计时期间屏蔽逐张日志
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// 每张照片取最大的人脸作为裁剪图，检测不到时取中心区域
+std::vector<cv::Mat> loadFaceCrops(const std::string& dir) {
+    std::vector<fs::path> paths;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (entry.is_regular_file() && (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp")) {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<cv::Mat> crops;
+    for (const auto& path : paths) {
+        cv::Mat image = cv::imread(path.string());
+        if (image.empty()) {
+            continue;
+        }
+        std::vector<cv::Rect> faces = detectFaces(image);
+        cv::Rect crop(image.cols / 4, image.rows / 4, image.cols / 2, image.rows / 2);
+        if (!faces.empty()) {
+            crop = *std::max_element(faces.begin(), faces.end(),
+                                     [](const cv::Rect& a, const cv::Rect& b) { return a.area() < b.area(); });
+        }
+        crops.push_back(image(crop).clone());
+    }
+    return crops;
+}
+
+// 合成裁剪图：平滑噪声，尺寸在 80~200 像素之间变化
+std::vector<cv::Mat> syntheticCrops(size_t count) {
+    cv::RNG rng(7);
+    std::vector<cv::Mat> crops;
+    for (size_t i = 0; i < count; ++i) {
+        int size = rng.uniform(80, 200);
+        cv::Mat crop(size, size, CV_8UC3);
+        rng.fill(crop, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+        cv::GaussianBlur(crop, crop, cv::Size(7, 7), 2.0);
+        crops.push_back(crop);
+    }
+    return crops;
+}
+
+std::vector<size_t> parseSizes(const std::string& text) {
+    std::vector<size_t> sizes;
+    std::istringstream fields(text);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        if (!field.empty()) {
+            sizes.push_back(std::max<size_t>(1, std::stoul(field)));
+        }
+    }
+    return sizes;
+}
+
+} // namespace
+
+// 批量特征提取基准：逐张提取与不同批大小的批量提取对比，给出每张人脸的平均耗时
+//   --images <dir>          人脸照片目录（默认pictures目录；每张取最大的人脸）
+//   --synthetic <n>         使用 n 张合成裁剪图代替照片
+//   --faces <n>             参与计时的人脸数，裁剪图循环使用（默认256）
+//   --batch-sizes <list>    批大小列表（默认1,2,4,8,16,32,64,128,256）
+//   --threads <n>           批量提取使用的线程数（默认1，即调用线程串行执行）
+//   --repeat <n>            每种配置重复次数，取最快一次（默认3）
+//   --tolerance <t>         与逐张提取结果的最大允许差值（默认1e-3），超出时返回1
+int main(int argc, char** argv)
+{
+    std::string imagesDir;
+    size_t synthetic = 0;
+    size_t faceCount = 256;
+    std::vector<size_t> batchSizes = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+    size_t threads = 1;
+    int repeat = 3;
+    double tolerance = 1e-3;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--images") imagesDir = argv[++i];
+        else if (arg == "--synthetic") synthetic = std::stoul(argv[++i]);
+        else if (arg == "--faces") faceCount = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (arg == "--batch-sizes") batchSizes = parseSizes(argv[++i]);
+        else if (arg == "--threads") threads = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (arg == "--repeat") repeat = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--tolerance") tolerance = std::stod(argv[++i]);
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+    if (batchSizes.empty()) {
+        cerr << "错误：批大小列表为空" << endl;
+        return -1;
+    }
+
+    // 1) 准备裁剪图
+    if (!load_model()) {
+        cerr << "错误：无法加载人脸识别模型" << endl;
+        return -1;
+    }
+    std::vector<cv::Mat> sources;
+    if (synthetic > 0) {
+        sources = syntheticCrops(synthetic);
+    } else {
+        sources = loadFaceCrops(imagesDir.empty() ? ::utils::getPicturesDirectory() : imagesDir);
+    }
+    if (sources.empty()) {
+        cerr << "错误：没有可用的人脸图像" << endl;
+        return -1;
+    }
+    std::vector<cv::Mat> crops;
+    for (size_t i = 0; i < faceCount; ++i) {
+        crops.push_back(sources[i % sources.size()]);
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1) {
+        pool.reset(new ThreadPool(threads - 1)); // 调用线程也参与 parallelFor
+    }
+    cv::setNumThreads(1); // 只测批量提取自身的并行
+
+    cout << "[BatchExtractBenchmark] 人脸数: " << crops.size() << " (" << sources.size() << " 张不同的裁剪图), 线程数: "
+         << threads << ", 每种配置重复 " << repeat << " 次取最快" << endl;
+
+    NullBuffer nullBuffer;
+    std::streambuf* coutBuffer = cout.rdbuf();
+
+    // 2) 基准：逐张调用 extract_face_features
+    std::vector<cv::Mat> reference(crops.size());
+    double baselineMs = 0.0;
+    cout.rdbuf(&nullBuffer);
+    for (int r = 0; r < repeat; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < crops.size(); ++i) {
+            std::vector<cv::Mat> features =
+                extract_face_features(crops[i], {cv::Rect(0, 0, crops[i].cols, crops[i].rows)});
+            reference[i] = features.empty() ? cv::Mat() : features[0];
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        baselineMs = r == 0 ? ms : std::min(baselineMs, ms);
+    }
+    cout.rdbuf(coutBuffer);
+    double baselineUs = baselineMs * 1000.0 / crops.size();
+
+    cout << left << setw(12) << "batch" << setw(14) << "us/face" << setw(12) << "faces/s"
+         << setw(10) << "speedup" << setw(14) << "max_abs_diff" << endl;
+    cout << left << fixed << setprecision(1) << setw(12) << "per-face" << setw(14) << baselineUs
+         << setw(12) << 1e6 / baselineUs << setw(10) << setprecision(2) << 1.0 << setw(14) << "-" << endl;
+
+    // 3) 各批大小的批量提取，并与逐张提取的结果比较
+    size_t mismatches = 0;
+    for (size_t batchSize : batchSizes) {
+        std::vector<cv::Mat> features(crops.size());
+        double bestMs = 0.0;
+        for (int r = 0; r < repeat; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t begin = 0; begin < crops.size(); begin += batchSize) {
+                size_t end = std::min(crops.size(), begin + batchSize);
+                std::vector<cv::Mat> batch(crops.begin() + begin, crops.begin() + end);
+                std::vector<cv::Mat> result = extract_face_features_batch(batch, pool.get());
+                std::copy(result.begin(), result.end(), features.begin() + begin);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            bestMs = r == 0 ? ms : std::min(bestMs, ms);
+        }
+
+        double maxDiff = 0.0;
+        for (size_t i = 0; i < crops.size(); ++i) {
+            if (reference[i].empty() || features[i].empty()) {
+                maxDiff = reference[i].empty() == features[i].empty() ? maxDiff : INFINITY;
+                continue;
+            }
+            maxDiff = std::max(maxDiff, cv::norm(reference[i], features[i], cv::NORM_INF));
+        }
+        if (!(maxDiff <= tolerance)) {
+            ++mismatches;
+        }
+
+        double us = bestMs * 1000.0 / crops.size();
+        cout << left << fixed << setprecision(1) << setw(12) << batchSize << setw(14) << us
+             << setw(12) << 1e6 / us << setw(10) << setprecision(2) << baselineUs / us
+             << setw(14) << scientific << setprecision(1) << maxDiff << endl;
+    }
+
+    cout << "[BatchExtractBenchmark] 每批 8 张人脸共用一组向量通道，批大小不是 8 的倍数时最后一组有空闲通道；"
+         << "max_abs_diff 为与逐张提取结果的最大差值" << endl;
+    if (mismatches > 0) {
+        cerr << "[BatchExtractBenchmark] 失败：" << mismatches << " 种批大小的结果与逐张提取的差值超过 "
+             << tolerance << endl;
+        return 1;
+    }
+    return 0;
+}
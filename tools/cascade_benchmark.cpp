@@ -0,0 +1,221 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "face_detection.h"
+#include "frame_log.h"
+#include "haar_cascade.h"
+#include "utils.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 一张待检测的灰度图（与 detectFaces 的默认预处理相同：转灰度 + 直方图均衡化）
+struct Sample {
+    std::string name;
+    cv::Mat gray;
+};
+
+cv::Mat preprocess(const cv::Mat& image) {
+    cv::Mat gray;
+    if (image.channels() == 1) {
+        gray = image.clone();
+    } else {
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    }
+    cv::equalizeHist(gray, gray);
+    return gray;
+}
+
+void loadImages(const std::string& dir, std::vector<Sample>& samples) {
+    std::vector<fs::path> paths;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (entry.is_regular_file() && (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp")) {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    for (const auto& path : paths) {
+        cv::Mat image = cv::imread(path.string());
+        if (!image.empty()) {
+            samples.push_back({path.filename().string(), preprocess(image)});
+        }
+    }
+}
+
+bool loadFrameLog(const std::string& path, size_t max_frames, std::vector<Sample>& samples) {
+    FrameLogReader reader;
+    if (!reader.open(path)) {
+        cerr << "错误：无法打开帧日志: " << path << endl;
+        return false;
+    }
+    cv::Mat frame;
+    for (size_t f = 0; f < reader.size() && f < max_frames; ++f) {
+        if (!reader.read(f, frame)) {
+            return false;
+        }
+        samples.push_back({"frame " + std::to_string(f), preprocess(frame)});
+    }
+    return true;
+}
+
+// 级联实现：对一张灰度图检测，min_neighbors = 0 时输出未分组的候选框
+using Detector = std::function<void(const cv::Mat&, int, std::vector<cv::Rect>&)>;
+
+struct Implementation {
+    std::string name;
+    Detector detect;
+};
+
+std::vector<cv::Rect> sorted(std::vector<cv::Rect> rects) {
+    std::sort(rects.begin(), rects.end(), [](const cv::Rect& a, const cv::Rect& b) {
+        return std::make_tuple(a.y, a.x, a.height, a.width) < std::make_tuple(b.y, b.x, b.height, b.width);
+    });
+    return rects;
+}
+
+} // namespace
+
+// 级联检测基准：对比 cv::CascadeClassifier 与扁平化级联（标量 / AVX2 内核）的耗时，并逐图校验检测结果一致
+//   --images <dir>          图像目录（默认pictures目录，传空字符串则不使用）
+//   --log <path>            帧日志文件（frame_recorder 录制），与图像一起参与对比
+//   --frames <n>            最多使用帧日志中的前n帧（默认全部）
+//   --repeat <n>            每种实现重复遍历的次数，取最快一次（默认3）
+//   --threads <n>           OpenCV 线程数（两种实现都按 cv::parallel_for_ 并行）
+//
+// 校验项：未分组候选框（min_neighbors = 0）与默认参数的分组结果都须与 OpenCV 完全相同，任一不同时返回非零
+int main(int argc, char** argv)
+{
+    std::string imagesDir = ::utils::getPicturesDirectory();
+    std::string logPath;
+    size_t maxFrames = (size_t)-1;
+    int repeat = 3;
+    int threads = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--images") imagesDir = argv[++i];
+        else if (arg == "--log") logPath = argv[++i];
+        else if (arg == "--frames") maxFrames = std::stoul(argv[++i]);
+        else if (arg == "--repeat") repeat = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--threads") threads = std::stoi(argv[++i]);
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+    if (threads >= 0) {
+        cv::setNumThreads(threads);
+    }
+
+    std::vector<Sample> samples;
+    if (!imagesDir.empty()) {
+        loadImages(imagesDir, samples);
+    }
+    if (!logPath.empty() && !loadFrameLog(logPath, maxFrames, samples)) {
+        return -1;
+    }
+    if (samples.empty()) {
+        cerr << "错误：没有可用的图像或帧" << endl;
+        return -1;
+    }
+
+    // 两种实现读取同一个模型文件
+    std::string modelPath = ::utils::getModelPath("haarcascade_frontalface_default.xml");
+    cv::FileStorage storage(modelPath, cv::FileStorage::READ);
+    cv::CascadeClassifier opencvCascade;
+    HaarCascade flatCascade;
+    if (!storage.isOpened() || !opencvCascade.read(storage.getFirstTopLevelNode()) ||
+        !flatCascade.read(storage.getFirstTopLevelNode())) {
+        cerr << "错误：无法加载级联模型: " << modelPath << endl;
+        return -1;
+    }
+
+    const DetectionParams params;
+    std::vector<Implementation> impls;
+    impls.push_back({"opencv", [&](const cv::Mat& gray, int minNeighbors, std::vector<cv::Rect>& faces) {
+        opencvCascade.detectMultiScale(gray, faces, params.scale_factor, minNeighbors, 0, params.min_size);
+    }});
+    impls.push_back({"flat", [&](const cv::Mat& gray, int minNeighbors, std::vector<cv::Rect>& faces) {
+        flatCascade.setUseSimd(false);
+        flatCascade.detectMultiScale(gray, faces, params.scale_factor, minNeighbors, params.min_size);
+    }});
+    if (HaarCascade::simdSupported()) {
+        impls.push_back({"flat_avx2", [&](const cv::Mat& gray, int minNeighbors, std::vector<cv::Rect>& faces) {
+            flatCascade.setUseSimd(true);
+            flatCascade.detectMultiScale(gray, faces, params.scale_factor, minNeighbors, params.min_size);
+        }});
+    } else {
+        cout << "[CascadeBenchmark] CPU 不支持 AVX2，跳过 SIMD 内核" << endl;
+    }
+
+    // 1) 逐图校验：候选框与分组结果
+    size_t mismatches = 0;
+    size_t candidates = 0;
+    size_t faces = 0;
+    for (const Sample& sample : samples) {
+        for (int minNeighbors : {0, params.min_neighbors}) {
+            std::vector<cv::Rect> expected;
+            impls[0].detect(sample.gray, minNeighbors, expected);
+            expected = sorted(expected);
+            (minNeighbors == 0 ? candidates : faces) += expected.size();
+            for (size_t k = 1; k < impls.size(); ++k) {
+                std::vector<cv::Rect> actual;
+                impls[k].detect(sample.gray, minNeighbors, actual);
+                if (sorted(actual) != expected) {
+                    mismatches++;
+                    cerr << "[CascadeBenchmark] 结果不一致: " << sample.name << " (" << impls[k].name
+                         << ", min_neighbors=" << minNeighbors << "): opencv " << expected.size()
+                         << " 个, " << impls[k].name << " " << actual.size() << " 个" << endl;
+                }
+            }
+        }
+    }
+
+    // 2) 计时：每种实现按默认参数遍历全部图像，取最快一遍
+    cout << "[CascadeBenchmark] " << samples.size() << " 张图像/帧, 候选框 " << candidates << " 个, 人脸 "
+         << faces << " 个, 线程 " << cv::getNumThreads() << ", 重复 " << repeat << " 次取最快" << endl;
+    cout << left << setw(12) << "impl" << setw(12) << "total_ms" << setw(12) << "frame_ms" << setw(10) << "speedup"
+         << endl;
+    double baselineMs = 0.0;
+    std::vector<cv::Rect> detections;
+    for (size_t k = 0; k < impls.size(); ++k) {
+        impls[k].detect(samples[0].gray, params.min_neighbors, detections); // 预热
+        double best = 0.0;
+        for (int r = 0; r < repeat; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            for (const Sample& sample : samples) {
+                impls[k].detect(sample.gray, params.min_neighbors, detections);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            best = r == 0 ? ms : std::min(best, ms);
+        }
+        if (k == 0) {
+            baselineMs = best;
+        }
+        cout << left << fixed << setw(12) << impls[k].name << setw(12) << setprecision(2) << best
+             << setw(12) << best / samples.size() << setw(10) << baselineMs / best << endl;
+    }
+
+    if (mismatches > 0) {
+        cerr << "[CascadeBenchmark] 失败：" << mismatches << " 项检测结果与 OpenCV 不一致" << endl;
+        return 1;
+    }
+    cout << "[CascadeBenchmark] 全部检测结果与 OpenCV 一致" << endl;
+    return 0;
+}
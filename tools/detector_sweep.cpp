@@ -0,0 +1,304 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "face_detection.h"
+#include "utils.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 一张带标注的图像
+struct LabeledImage {
+    std::string name;
+    cv::Mat image;
+    std::vector<cv::Rect> boxes;   // 真值框
+    bool annotated;                // 未标注的图像只参与计时，不计入召回率/精确率
+};
+
+// 一组参数的评估结果
+struct SweepResult {
+    DetectionParams params;
+    double mean_ms = 0.0;
+    size_t tp = 0, fp = 0, fn = 0;
+    double recall = 0.0;
+    double precision = 0.0;
+    double f1 = 0.0;
+    bool pareto = false;
+};
+
+// 丢弃输出的流缓冲，计时期间屏蔽检测日志
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+double iou(const cv::Rect& a, const cv::Rect& b) {
+    double inter = (a & b).area();
+    double uni = a.area() + b.area() - inter;
+    return uni > 0 ? inter / uni : 0.0;
+}
+
+// 读取标注文件：每行 "文件名,x,y,w,h"，同一文件可出现多行；"文件名" 单独一行表示无人脸
+std::map<std::string, std::vector<cv::Rect>> loadAnnotations(const std::string& path) {
+    std::map<std::string, std::vector<cv::Rect>> annotations;
+    std::ifstream in(path);
+    if (!in) {
+        cerr << "[DetectorSweep] 错误：无法读取标注文件: " << path << endl;
+        return annotations;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        std::string name;
+        int x, y, w, h;
+        fields >> name;
+        auto& boxes = annotations[name];
+        if (fields >> x >> y >> w >> h) {
+            boxes.push_back(cv::Rect(x, y, w, h));
+        }
+    }
+    return annotations;
+}
+
+// 贪心匹配检测框与真值框（IoU ≥ 0.5）；未标注的图像没有真值，不计分
+void scoreImage(const LabeledImage& image, const std::vector<cv::Rect>& detections, SweepResult& result) {
+    if (!image.annotated) {
+        return;
+    }
+
+    std::vector<bool> used(detections.size(), false);
+    for (const auto& box : image.boxes) {
+        int best = -1;
+        double best_iou = 0.5;
+        for (size_t d = 0; d < detections.size(); ++d) {
+            double overlap = iou(box, detections[d]);
+            if (!used[d] && overlap >= best_iou) {
+                best_iou = overlap;
+                best = (int)d;
+            }
+        }
+        if (best >= 0) {
+            used[best] = true;
+            result.tp++;
+        } else {
+            result.fn++;
+        }
+    }
+    result.fp += std::count(used.begin(), used.end(), false);
+}
+
+// a 在耗时、召回率、精确率上都不差于 b 且至少一项更好
+bool dominates(const SweepResult& a, const SweepResult& b) {
+    bool no_worse = a.mean_ms <= b.mean_ms && a.recall >= b.recall && a.precision >= b.precision;
+    bool better = a.mean_ms < b.mean_ms || a.recall > b.recall || a.precision > b.precision;
+    return no_worse && better;
+}
+
+} // namespace
+
+// 检测参数扫描：在带标注的图像集上评估参数网格的速度与召回率/精确率，输出 Pareto 前沿
+//   --images <dir>          图像目录（默认pictures目录）
+//   --annotations <csv>     标注文件（"文件名,x,y,w,h"），未标注的图像只参与计时
+//   --output <prefix>       输出 <prefix>.csv 和 <prefix>.json（默认 detector_sweep）
+//   --repeat <n>            每张图像的计时重复次数（默认3）
+int main(int argc, char** argv)
+{
+    std::string imagesDir;
+    std::string annotationsPath;
+    std::string outputPrefix = "detector_sweep";
+    int repeat = 3;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--images") imagesDir = argv[++i];
+        else if (arg == "--annotations") annotationsPath = argv[++i];
+        else if (arg == "--output") outputPrefix = argv[++i];
+        else if (arg == "--repeat") repeat = std::max(1, std::stoi(argv[++i]));
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+    if (imagesDir.empty()) {
+        imagesDir = ::utils::getPicturesDirectory();
+    }
+
+    // 1) 读取图像与标注
+    std::map<std::string, std::vector<cv::Rect>> annotations;
+    if (!annotationsPath.empty()) {
+        annotations = loadAnnotations(annotationsPath);
+    }
+
+    std::vector<LabeledImage> images;
+    for (const auto& entry : fs::directory_iterator(imagesDir)) {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (!entry.is_regular_file() || (ext != ".jpg" && ext != ".jpeg" && ext != ".png" && ext != ".bmp")) {
+            continue;
+        }
+
+        LabeledImage image;
+        image.name = entry.path().filename().string();
+        image.image = cv::imread(entry.path().string());
+        if (image.image.empty()) {
+            continue;
+        }
+        auto it = annotations.find(image.name);
+        image.annotated = it != annotations.end();
+        if (image.annotated) {
+            image.boxes = it->second;
+        }
+        images.push_back(image);
+    }
+    std::sort(images.begin(), images.end(),
+              [](const LabeledImage& a, const LabeledImage& b) { return a.name < b.name; });
+
+    if (images.empty()) {
+        cerr << "[DetectorSweep] 错误：没有可用的图像: " << imagesDir << endl;
+        return -1;
+    }
+    size_t annotatedCount = std::count_if(images.begin(), images.end(),
+                                          [](const LabeledImage& image) { return image.annotated; });
+    cout << "[DetectorSweep] 图像: " << images.size() << " 张, 已标注: " << annotatedCount << " 张" << endl;
+    if (annotatedCount == 0) {
+        cerr << "[DetectorSweep] 警告：没有图像匹配到标注，只比较耗时，召回率/精确率均为 0" << endl;
+    } else if (annotatedCount < images.size()) {
+        cerr << "[DetectorSweep] 警告：" << images.size() - annotatedCount
+             << " 张图像没有标注，只参与计时，不计入召回率/精确率" << endl;
+    }
+
+    // 2) 参数网格
+    std::vector<double> scaleFactors = {1.05, 1.1, 1.2, 1.3};
+    std::vector<int> minNeighbors = {2, 3, 4, 5};
+    std::vector<int> minSizes = {20, 30, 40, 60};
+    std::vector<double> inputScales = {1.0, 0.75, 0.5};
+    std::vector<bool> equalizeOptions = {true, false};
+
+    std::vector<SweepResult> results;
+    NullBuffer nullBuffer;
+    std::streambuf* coutBuffer = cout.rdbuf();
+
+    // 预热：加载级联分类器
+    cout.rdbuf(&nullBuffer);
+    detectFaces(images[0].image);
+    cout.rdbuf(coutBuffer);
+
+    for (double scaleFactor : scaleFactors)
+    for (int neighbors : minNeighbors)
+    for (int minSize : minSizes)
+    for (double inputScale : inputScales)
+    for (bool equalize : equalizeOptions) {
+        SweepResult result;
+        result.params.scale_factor = scaleFactor;
+        result.params.min_neighbors = neighbors;
+        result.params.min_size = cv::Size(minSize, minSize);
+        result.params.input_scale = inputScale;
+        result.params.equalize_hist = equalize;
+
+        double totalMs = 0.0;
+        cout.rdbuf(&nullBuffer);
+        for (const auto& image : images) {
+            std::vector<cv::Rect> detections;
+            for (int r = 0; r < repeat; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                detections = detectFaces(image.image, result.params);
+                totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            scoreImage(image, detections, result);
+        }
+        cout.rdbuf(coutBuffer);
+
+        result.mean_ms = totalMs / (images.size() * repeat);
+        result.recall = result.tp + result.fn > 0 ? (double)result.tp / (result.tp + result.fn) : 0.0;
+        result.precision = result.tp + result.fp > 0 ? (double)result.tp / (result.tp + result.fp) : 0.0;
+        result.f1 = result.recall + result.precision > 0
+            ? 2.0 * result.recall * result.precision / (result.recall + result.precision) : 0.0;
+        results.push_back(result);
+    }
+
+    // 3) 计算 Pareto 前沿（耗时越低、召回率和精确率越高越好）
+    for (auto& candidate : results) {
+        candidate.pareto = std::none_of(results.begin(), results.end(),
+                                        [&](const SweepResult& other) { return dominates(other, candidate); });
+    }
+    std::sort(results.begin(), results.end(),
+              [](const SweepResult& a, const SweepResult& b) { return a.mean_ms < b.mean_ms; });
+
+    // 4) 输出 CSV（全部配置）与 JSON（全部配置 + Pareto 前沿）
+    std::ofstream csv(outputPrefix + ".csv");
+    csv << "scale_factor,min_neighbors,min_size,input_scale,equalize_hist,mean_ms,tp,fp,fn,recall,precision,f1,pareto\n";
+    for (const auto& r : results) {
+        csv << std::fixed << std::setprecision(4)
+            << r.params.scale_factor << "," << r.params.min_neighbors << "," << r.params.min_size.width << ","
+            << r.params.input_scale << "," << (r.params.equalize_hist ? 1 : 0) << "," << r.mean_ms << ","
+            << r.tp << "," << r.fp << "," << r.fn << "," << r.recall << "," << r.precision << "," << r.f1 << ","
+            << (r.pareto ? 1 : 0) << "\n";
+    }
+
+    auto writeJsonEntry = [](std::ofstream& out, const SweepResult& r) {
+        out << std::fixed << std::setprecision(4)
+            << "{\"scale_factor\": " << r.params.scale_factor
+            << ", \"min_neighbors\": " << r.params.min_neighbors
+            << ", \"min_size\": " << r.params.min_size.width
+            << ", \"input_scale\": " << r.params.input_scale
+            << ", \"equalize_hist\": " << (r.params.equalize_hist ? "true" : "false")
+            << ", \"mean_ms\": " << r.mean_ms
+            << ", \"recall\": " << r.recall
+            << ", \"precision\": " << r.precision
+            << ", \"f1\": " << r.f1
+            << ", \"pareto\": " << (r.pareto ? "true" : "false") << "}";
+    };
+
+    std::ofstream json(outputPrefix + ".json");
+    json << "{\n  \"images\": " << images.size() << ",\n  \"annotated_images\": " << annotatedCount
+         << ",\n  \"repeat\": " << repeat << ",\n  \"pareto_front\": [\n";
+    bool first = true;
+    for (const auto& r : results) {
+        if (!r.pareto) continue;
+        json << (first ? "" : ",\n") << "    ";
+        writeJsonEntry(json, r);
+        first = false;
+    }
+    json << "\n  ],\n  \"configs\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        json << "    ";
+        writeJsonEntry(json, results[i]);
+        json << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    // 5) 打印 Pareto 前沿
+    cout << "[DetectorSweep] 共 " << results.size() << " 组参数，Pareto 前沿:" << endl;
+    cout << left << setw(8) << "scale" << setw(10) << "neighbors" << setw(9) << "minSize" << setw(8) << "input"
+         << setw(6) << "eq" << setw(10) << "ms/img" << setw(9) << "recall" << setw(10) << "precision" << endl;
+    for (const auto& r : results) {
+        if (!r.pareto) continue;
+        cout << left << fixed << setprecision(2)
+             << setw(8) << r.params.scale_factor << setw(10) << r.params.min_neighbors
+             << setw(9) << r.params.min_size.width << setw(8) << r.params.input_scale
+             << setw(6) << (r.params.equalize_hist ? "on" : "off") << setw(10) << setprecision(3) << r.mean_ms
+             << setw(9) << r.recall << setw(10) << r.precision << endl;
+    }
+    cout << "[DetectorSweep] 结果已写入 " << outputPrefix << ".csv / " << outputPrefix << ".json" << endl;
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "frame_log.h"
+#include "utils.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 读取目录中的全部图片（按文件名排序），统一缩放到 size
+std::vector<cv::Mat> loadImageDirectory(const std::string& dir, const cv::Size& size) {
+    std::vector<fs::path> paths;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (entry.is_regular_file() && (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp")) {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<cv::Mat> images;
+    for (const auto& path : paths) {
+        cv::Mat image = cv::imread(path.string());
+        if (image.empty()) {
+            continue;
+        }
+        cv::resize(image, image, size);
+        images.push_back(image);
+    }
+    return images;
+}
+
+bool isNumber(const std::string& text) {
+    return !text.empty() && std::all_of(text.begin(), text.end(), ::isdigit);
+}
+
+} // namespace
+
+// 帧日志录制：从摄像头、视频文件/流或图片目录采集帧，连同时间戳写入帧日志
+//   --source <src>          摄像头编号、视频文件/URL 或图片目录（默认摄像头0；"pictures" 表示项目的pictures目录）
+//   --output <path>         输出帧日志（默认frames.flog）
+//   --frames <n>            录制帧数（默认300）
+//   --encoding <raw|png>    帧存储方式（默认raw；png为无损压缩）
+//   --png-level <n>         PNG 压缩等级0-9（默认1，压缩快）
+//   --fps <n>               图片目录的合成帧率（默认30）
+//   --size <WxH>            图片目录的帧尺寸（默认640x480）
+int main(int argc, char** argv)
+{
+    std::string source = "0";
+    std::string outputPath = "frames.flog";
+    size_t frames = 300;
+    std::string encodingName = "raw";
+    int pngLevel = 1;
+    double fps = 30.0;
+    cv::Size size(640, 480);
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--source") source = argv[++i];
+        else if (arg == "--output") outputPath = argv[++i];
+        else if (arg == "--frames") frames = std::stoul(argv[++i]);
+        else if (arg == "--encoding") encodingName = argv[++i];
+        else if (arg == "--png-level") pngLevel = std::stoi(argv[++i]);
+        else if (arg == "--fps") fps = std::max(1.0, std::stod(argv[++i]));
+        else if (arg == "--size") {
+            std::string value = argv[++i];
+            size_t x = value.find('x');
+            if (x == std::string::npos) {
+                cerr << "帧尺寸格式应为 WxH: " << value << endl;
+                return -1;
+            }
+            size = cv::Size(std::stoi(value.substr(0, x)), std::stoi(value.substr(x + 1)));
+        } else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+    if (encodingName != "raw" && encodingName != "png") {
+        cerr << "未知的存储方式: " << encodingName << endl;
+        return -1;
+    }
+    if (source == "pictures") {
+        source = ::utils::getPicturesDirectory();
+    }
+
+    FrameLogWriter writer;
+    if (!writer.open(outputPath, encodingName == "png" ? FrameEncoding::PNG : FrameEncoding::RAW, pngLevel)) {
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (fs::is_directory(source)) {
+        // 图片目录：循环使用目录中的图片，按固定帧率生成时间戳，得到可复现的测试日志
+        std::vector<cv::Mat> images = loadImageDirectory(source, size);
+        if (images.empty()) {
+            cerr << "错误：目录中没有可用的图片: " << source << endl;
+            return -1;
+        }
+        for (size_t f = 0; f < frames; ++f) {
+            uint64_t timestamp = (uint64_t)(f * 1e6 / fps);
+            if (!writer.write(images[f % images.size()], timestamp)) {
+                return -1;
+            }
+        }
+    } else {
+        cv::VideoCapture cap;
+        bool opened = isNumber(source) ? cap.open(std::stoi(source)) : cap.open(source);
+        if (!opened || !cap.isOpened()) {
+            cerr << "错误：无法打开视频源: " << source << endl;
+            return -1;
+        }
+
+        // 时间戳取采集时刻，保留真实的帧间隔（包括抖动和丢帧）
+        cv::Mat frame;
+        std::chrono::steady_clock::time_point first;
+        for (size_t f = 0; f < frames; ++f) {
+            cap >> frame;
+            if (frame.empty()) {
+                break;
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (f == 0) {
+                first = now;
+            }
+            uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(now - first).count();
+            if (!writer.write(frame, timestamp)) {
+                return -1;
+            }
+        }
+    }
+
+    size_t written = writer.frameCount();
+    uint64_t bytes = writer.bytesWritten();
+    if (!writer.close()) {
+        return -1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    cout << "[FrameRecorder] 已录制 " << written << " 帧到 " << outputPath << " (" << encodingName
+         << ", " << std::fixed << std::setprecision(1) << bytes / 1048576.0 << " MB, 平均每帧 "
+         << (written > 0 ? bytes / 1024.0 / written : 0.0) << " KB, 耗时 " << std::setprecision(2)
+         << seconds << " s)" << endl;
+    return written > 0 ? 0 : -1;
+}
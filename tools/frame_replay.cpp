@@ -0,0 +1,247 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "face_manager.h"
+#include "face_recognition.h"
+#include "frame_log.h"
+#include "recognition_engine.h"
+#include "utils.h"
+
+using namespace std;
+
+namespace {
+
+// 丢弃输出的流缓冲，回放期间屏蔽逐帧日志
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// 最近秩百分位数
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = (size_t)std::ceil(p / 100.0 * values.size());
+    return values[std::min(values.size(), std::max<size_t>(1, rank)) - 1];
+}
+
+// 读取预算文件：每行 "名称 数值"，# 开头为注释
+bool loadBudget(const std::string& path, std::map<std::string, double>& budget) {
+    std::ifstream in(path);
+    if (!in) {
+        cerr << "错误：无法读取预算文件: " << path << endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        double value;
+        if (fields >> name >> value) {
+            budget[name] = value;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// 帧日志回放：用录制的帧驱动识别引擎，测量吞吐量与单帧延迟，可按预算文件判定是否回归
+//   --log <path>            帧日志文件（默认frames.flog）
+//   --mode <fast|realtime>  fast 尽快处理；realtime 按录制时的时间戳送帧（默认fast）
+//   --repeat <n>            回放遍数（默认1）
+//   --warmup <n>            不计入统计的预热帧数（默认10）
+//   --threads <n>           引擎线程预算（同主程序的 --threads）
+//   --motion-gate           启用运动门控
+//   --budget <path>         预算文件，超出任一预算时返回非零（用于性能回归测试）
+//
+// 预算文件中可用的项目：
+//   min_fps            最低吞吐量（帧/秒）
+//   max_mean_ms        单帧处理耗时均值上限
+//   max_p99_ms         单帧处理耗时 p99 上限
+//   max_lag_p99_ms     realtime 模式下完成时刻相对录制时刻的滞后 p99 上限
+int main(int argc, char** argv)
+{
+    std::string logPath = "frames.flog";
+    std::string mode = "fast";
+    int repeat = 1;
+    size_t warmup = 10;
+    std::string budgetPath;
+    MotionGateOptions motionGateOptions;
+    ParallelOptions parallelOptions;
+    bool parallelConfigured = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--motion-gate") {
+            motionGateOptions.enabled = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--log") logPath = argv[++i];
+        else if (arg == "--mode") mode = argv[++i];
+        else if (arg == "--repeat") repeat = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--warmup") warmup = std::stoul(argv[++i]);
+        else if (arg == "--budget") budgetPath = argv[++i];
+        else if (arg == "--threads") {
+            parallelOptions.threads = std::stoul(argv[++i]);
+            parallelConfigured = true;
+        } else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+    if (mode != "fast" && mode != "realtime") {
+        cerr << "未知的回放模式: " << mode << endl;
+        return -1;
+    }
+
+    std::map<std::string, double> budget;
+    if (!budgetPath.empty() && !loadBudget(budgetPath, budget)) {
+        return -1;
+    }
+
+    FrameLogReader reader;
+    if (!reader.open(logPath) || reader.size() == 0) {
+        cerr << "错误：帧日志为空或无法打开: " << logPath << endl;
+        return -1;
+    }
+
+    // 注册pictures目录中的人脸，与主程序的按身份匹配路径一致
+    if (!load_model()) {
+        cerr << "错误：无法加载人脸识别模型" << endl;
+        return -1;
+    }
+    FaceManager manager;
+    if (!manager.initialize(::utils::getPicturesDirectory()) || !manager.autoScanAndRegister()) {
+        cerr << "错误：无法注册pictures目录中的人脸" << endl;
+        return -1;
+    }
+
+    RecognitionEngine engine;
+    engine.initialize();
+    engine.setMotionGate(motionGateOptions);
+    if (parallelConfigured) {
+        engine.configureParallel(parallelOptions);
+    }
+
+    // 回放：realtime 模式下第 i 帧在 起点 + timestamp_i 时送入，处理落后时立即送入并记为迟到
+    std::vector<double> latencies;
+    std::vector<double> lags;
+    size_t lateFrames = 0;
+    size_t recognized = 0;
+    size_t faces = 0;
+    size_t measured = 0;
+    double measuredSeconds = 0.0;
+    RecognitionResults results;
+    cv::Mat frame;
+
+    NullBuffer null;
+    std::streambuf* saved = cout.rdbuf(&null);
+    for (int pass = 0; pass < repeat; ++pass) {
+        auto passStart = std::chrono::steady_clock::now();
+        for (size_t f = 0; f < reader.size(); ++f) {
+            bool counted = pass > 0 || f >= warmup;
+            auto scheduled = passStart + std::chrono::microseconds(reader.entry(f).timestamp_us);
+            if (mode == "realtime") {
+                if (std::chrono::steady_clock::now() < scheduled) {
+                    std::this_thread::sleep_until(scheduled);
+                } else if (counted && f > 0) {
+                    lateFrames++;
+                }
+            }
+
+            auto begin = std::chrono::steady_clock::now();
+            if (!reader.read(f, frame)) {
+                cout.rdbuf(saved);
+                return -1;
+            }
+            engine.processFrame(frame, manager.getIdentities(), results);
+            auto end = std::chrono::steady_clock::now();
+
+            if (!counted) {
+                continue;
+            }
+            measured++;
+            measuredSeconds += std::chrono::duration<double>(end - begin).count();
+            latencies.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+            if (mode == "realtime") {
+                lags.push_back(std::chrono::duration<double, std::milli>(end - scheduled).count());
+            }
+            faces += results.size();
+            for (const auto& result : results) {
+                if (result.label_id != kUnknownLabel) {
+                    recognized++;
+                }
+            }
+        }
+    }
+    cout.rdbuf(saved);
+
+    if (measured == 0) {
+        cerr << "错误：预热帧数不小于日志帧数，没有可统计的帧" << endl;
+        return -1;
+    }
+
+    // realtime 模式的吞吐量受录制帧率限制，按处理耗时之和计算的是引擎可达到的上限
+    double mean = measuredSeconds * 1000.0 / measured;
+    double fps = measured / measuredSeconds;
+    double p50 = percentile(latencies, 50);
+    double p99 = percentile(latencies, 99);
+    double maxLatency = *std::max_element(latencies.begin(), latencies.end());
+    double lagP99 = percentile(lags, 99);
+
+    cout << "[FrameReplay] 模式: " << mode << ", 帧数: " << measured << " (" << repeat << " 遍, 预热 " << warmup
+         << " 帧), 人脸: " << faces << ", 识别: " << recognized << endl;
+    cout << "[FrameReplay] 吞吐量: " << std::fixed << std::setprecision(1) << fps << " FPS, 单帧耗时 mean "
+         << std::setprecision(2) << mean << " ms, p50 " << p50 << " ms, p99 " << p99 << " ms, max "
+         << maxLatency << " ms" << endl;
+    if (mode == "realtime") {
+        cout << "[FrameReplay] 相对录制时刻的滞后 p99: " << lagP99 << " ms, 迟到帧: " << lateFrames << endl;
+    }
+
+    // 预算判定
+    bool passed = true;
+    auto check = [&](const std::string& name, double value, bool upper) {
+        auto it = budget.find(name);
+        if (it == budget.end()) {
+            return;
+        }
+        bool ok = upper ? value <= it->second : value >= it->second;
+        cout << "[FrameReplay] " << (ok ? "通过" : "超出预算") << ": " << name << " = " << value
+             << (upper ? " (上限 " : " (下限 ") << it->second << ")" << endl;
+        passed = passed && ok;
+    };
+    check("min_fps", fps, false);
+    check("max_mean_ms", mean, true);
+    check("max_p99_ms", p99, true);
+    if (mode == "realtime") {
+        check("max_lag_p99_ms", lagP99, true);
+    }
+    for (const auto& item : budget) {
+        if (item.first != "min_fps" && item.first != "max_mean_ms" && item.first != "max_p99_ms" &&
+            item.first != "max_lag_p99_ms") {
+            cerr << "[FrameReplay] 警告：未知的预算项: " << item.first << endl;
+        }
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "face_manager.h"
+#include "face_recognition.h"
+#include "feature_matrix.h"
+#include "thread_pool.h"
+#include "tiered_gallery.h"
+#include "utils.h"
+
+using namespace std;
+
+namespace {
+
+// 并查集（按大小合并 + 路径压缩）
+class DisjointSet {
+public:
+    explicit DisjointSet(size_t n) : parent_(n), size_(n, 1) {
+        for (size_t i = 0; i < n; ++i) {
+            parent_[i] = (uint32_t)i;
+        }
+    }
+
+    uint32_t find(uint32_t x) {
+        while (parent_[x] != x) {
+            parent_[x] = parent_[parent_[x]];
+            x = parent_[x];
+        }
+        return x;
+    }
+
+    void unite(uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) {
+            return;
+        }
+        if (size_[a] < size_[b]) {
+            std::swap(a, b);
+        }
+        parent_[b] = a;
+        size_[a] += size_[b];
+    }
+
+private:
+    std::vector<uint32_t> parent_;
+    std::vector<uint32_t> size_;
+};
+
+// 随机图库：每隔 1000 个身份植入一个与之前某个身份几乎相同的重复项
+void buildSynthetic(size_t count, int dimension, std::vector<float>& features,
+                    std::vector<std::string>& labels, size_t& planted) {
+    std::mt19937 rng(42);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    features.resize(count * dimension);
+    labels.resize(count);
+    planted = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        float* row = features.data() + i * dimension;
+        if (i > 0 && i % 1000 == 0) {
+            size_t source = rng() % i;
+            for (int d = 0; d < dimension; ++d) {
+                row[d] = features[source * dimension + d] + 0.01f * normal(rng);
+            }
+            labels[i] = "dup_of_" + std::to_string(source);
+            planted++;
+        } else {
+            for (int d = 0; d < dimension; ++d) {
+                row[d] = normal(rng);
+            }
+            labels[i] = "id_" + std::to_string(i);
+        }
+    }
+}
+
+} // namespace
+
+// 图库审计：分块并行计算全对相似度，找出疑似重复的身份或样本并按连通分量聚类
+//   --gallery-file <path>   审计分层图库文件（默认扫描pictures目录）
+//   --level <identity|sample>  pictures模式下按身份平均模板或逐个样本比较（默认identity）
+//   --synthetic <n>         使用n个随机身份（含植入的重复项）测试规模与速度
+//   --threshold <t>         相似度阈值（默认0.95）
+//   --threads <n>           线程数（默认可用CPU数）
+//   --block <n>             分块大小（默认128）
+//   --pairs <csv>           逐条写出超过阈值的特征对（默认audit_pairs.csv）
+//   --clusters <csv>        写出聚类结果（默认audit_clusters.csv）
+int main(int argc, char** argv)
+{
+    std::string galleryFile;
+    std::string level = "identity";
+    size_t synthetic = 0;
+    float threshold = 0.95f;
+    size_t threads = 0;
+    size_t block = 128;
+    std::string pairsPath = "audit_pairs.csv";
+    std::string clustersPath = "audit_clusters.csv";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--gallery-file") galleryFile = argv[++i];
+        else if (arg == "--level") level = argv[++i];
+        else if (arg == "--synthetic") synthetic = std::stoul(argv[++i]);
+        else if (arg == "--threshold") threshold = std::stof(argv[++i]);
+        else if (arg == "--threads") threads = std::stoul(argv[++i]);
+        else if (arg == "--block") block = std::stoul(argv[++i]);
+        else if (arg == "--pairs") pairsPath = argv[++i];
+        else if (arg == "--clusters") clustersPath = argv[++i];
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+    if (level != "identity" && level != "sample") {
+        cerr << "未知的审计粒度: " << level << endl;
+        return -1;
+    }
+
+    // 1) 加载特征
+    auto loadStart = std::chrono::steady_clock::now();
+    FeatureMatrix matrix;
+    std::vector<std::string> labels;
+    size_t planted = 0;
+
+    if (synthetic > 0) {
+        std::vector<float> features;
+        buildSynthetic(synthetic, 128, features, labels, planted);
+        matrix = FeatureMatrix::fromRows(features.data(), synthetic, 128);
+    } else if (!galleryFile.empty()) {
+        TieredGallery gallery;
+        std::vector<float> features;
+        if (!gallery.open(galleryFile, 64 * 1024 * 1024) || !gallery.readAll(features, labels)) {
+            cerr << "错误：无法读取图库文件: " << galleryFile << endl;
+            return -1;
+        }
+        matrix = FeatureMatrix::fromRows(features.data(), gallery.size(), gallery.dimension());
+    } else {
+        if (!load_model()) {
+            cerr << "错误：无法加载人脸识别模型" << endl;
+            return -1;
+        }
+        FaceManager manager;
+        if (!manager.initialize(::utils::getPicturesDirectory()) || !manager.autoScanAndRegister()) {
+            cerr << "错误：无法注册pictures目录中的人脸" << endl;
+            return -1;
+        }
+        if (level == "identity") {
+            std::vector<cv::Mat> centroids;
+            for (const auto& identity : manager.getIdentities()) {
+                centroids.push_back(identity.centroid);
+                labels.push_back(identity.label);
+            }
+            matrix = FeatureMatrix::fromMats(centroids);
+        } else {
+            matrix = FeatureMatrix::fromMats(manager.getKnownFeatures());
+            labels = manager.getKnownLabels();
+        }
+    }
+    if (matrix.rows() < 2) {
+        cerr << "[GalleryAudit] 特征数量不足，无需审计" << endl;
+        return 0;
+    }
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+
+    ThreadPool pool(threads);
+    cout << "[GalleryAudit] 特征: " << matrix.rows() << " × " << matrix.dimension()
+         << ", 阈值: " << threshold << ", 线程: " << pool.size() << ", 分块: " << block
+         << ", 加载耗时: " << std::fixed << std::setprecision(2) << loadSeconds << " s" << endl;
+
+    // 2) 分块计算并流式写出超过阈值的对
+    std::ofstream pairsOut(pairsPath);
+    pairsOut << "i,j,label_i,label_j,similarity\n";
+    DisjointSet clusters(matrix.rows());
+    uint64_t sameLabelPairs = 0;
+    uint64_t crossLabelPairs = 0;
+
+    AllPairsStats stats = forEachSimilarPair(matrix, threshold, pool,
+        [&](const std::vector<SimilarPair>& pairs) {
+            for (const auto& pair : pairs) {
+                clusters.unite(pair.i, pair.j);
+                if (labels[pair.i] == labels[pair.j]) {
+                    sameLabelPairs++;
+                } else {
+                    crossLabelPairs++;
+                }
+                pairsOut << pair.i << "," << pair.j << "," << labels[pair.i] << "," << labels[pair.j]
+                         << "," << std::setprecision(4) << pair.similarity << "\n";
+            }
+        }, block);
+
+    cout << "[GalleryAudit] 比较 " << stats.pairs_compared << " 对, 耗时 " << std::setprecision(2)
+         << stats.seconds << " s (" << std::setprecision(1) << stats.gflops << " GFLOP/s)"
+         << ", 超过阈值: " << stats.pairs_reported
+         << " (不同标签: " << crossLabelPairs << ", 同标签重复样本: " << sameLabelPairs << ")" << endl;
+
+    // 3) 按连通分量汇总疑似重复聚类
+    std::map<uint32_t, std::vector<uint32_t>> groups;
+    for (uint32_t i = 0; i < matrix.rows(); ++i) {
+        groups[clusters.find(i)].push_back(i);
+    }
+    std::vector<std::vector<uint32_t>> suspects;
+    for (auto& group : groups) {
+        if (group.second.size() > 1) {
+            suspects.push_back(std::move(group.second));
+        }
+    }
+    std::sort(suspects.begin(), suspects.end(),
+              [](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) { return a.size() > b.size(); });
+
+    std::ofstream clustersOut(clustersPath);
+    clustersOut << "cluster,index,label\n";
+    for (size_t c = 0; c < suspects.size(); ++c) {
+        for (uint32_t index : suspects[c]) {
+            clustersOut << c << "," << index << "," << labels[index] << "\n";
+        }
+    }
+
+    cout << "[GalleryAudit] 疑似重复聚类: " << suspects.size() << " 个" << endl;
+    const size_t maxPrint = 20;
+    for (size_t c = 0; c < suspects.size() && c < maxPrint; ++c) {
+        cout << "  #" << c << " (" << suspects[c].size() << "):";
+        for (size_t k = 0; k < suspects[c].size() && k < 8; ++k) {
+            cout << " " << labels[suspects[c][k]];
+        }
+        if (suspects[c].size() > 8) {
+            cout << " …";
+        }
+        cout << endl;
+    }
+    if (suspects.size() > maxPrint) {
+        cout << "  …（其余见 " << clustersPath << "）" << endl;
+    }
+    if (synthetic > 0) {
+        cout << "[GalleryAudit] 植入重复项: " << planted << endl;
+    }
+    cout << "[GalleryAudit] 结果已写入 " << pairsPath << " / " << clustersPath << endl;
+    return 0;
+}
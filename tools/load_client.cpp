@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ipc.h"
+#include "recognition_server.h"
+#include "utils.h"
+
+using namespace std;
+
+namespace {
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(values.size() * p))];
+}
+
+// 读取图像文件的原始字节（服务端负责解码）
+bool readFileBytes(const std::string& path, std::vector<uint8_t>& bytes) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !bytes.empty();
+}
+
+} // namespace
+
+// 识别服务压测客户端
+//   --socket <path>        服务端套接字（默认 /tmp/face_recognition.sock）
+//   --image <path>         请求使用的图像（默认pictures目录中的全部图片轮流使用）
+//   --face                 以已裁剪人脸方式发送（默认发送整幅图像）
+//   --connections <n>      并发连接数（默认8）
+//   --requests <n>         每个连接的请求数（默认50）
+int main(int argc, char** argv)
+{
+    std::string socketPath = "/tmp/face_recognition.sock";
+    std::string imagePath;
+    uint8_t requestType = REQUEST_IMAGE;
+    int connections = 8;
+    int requestsPerConnection = 50;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--face") {
+            requestType = REQUEST_FACE;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--socket") socketPath = argv[++i];
+        else if (arg == "--image") imagePath = argv[++i];
+        else if (arg == "--connections") connections = std::stoi(argv[++i]);
+        else if (arg == "--requests") requestsPerConnection = std::stoi(argv[++i]);
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+
+    // 1) 准备请求图像
+    std::vector<std::vector<uint8_t>> images;
+    std::vector<std::string> paths;
+    if (!imagePath.empty()) {
+        paths.push_back(imagePath);
+    } else {
+        for (const auto& entry : std::filesystem::directory_iterator(::utils::getPicturesDirectory())) {
+            std::string ext = entry.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (entry.is_regular_file() && (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp")) {
+                paths.push_back(entry.path().string());
+            }
+        }
+    }
+    for (const auto& path : paths) {
+        std::vector<uint8_t> bytes;
+        if (readFileBytes(path, bytes)) {
+            images.push_back(std::move(bytes));
+        }
+    }
+    if (images.empty()) {
+        cerr << "[LoadClient] 错误：没有可用的请求图像" << endl;
+        return -1;
+    }
+
+    // 2) 并发发送请求
+    std::mutex mutex;
+    std::vector<double> latencies;
+    size_t failures = 0;
+    size_t facesReturned = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < connections; ++c) {
+        threads.emplace_back([&, c]() {
+            int fd = ipc::connectUnix(socketPath);
+            if (fd < 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                failures += requestsPerConnection;
+                return;
+            }
+
+            std::vector<double> local;
+            size_t localFailures = 0;
+            size_t localFaces = 0;
+            std::vector<uint8_t> response;
+            for (int r = 0; r < requestsPerConnection; ++r) {
+                const auto& image = images[(c + r) % images.size()];
+                ipc::Writer writer;
+                writer.putU8(requestType);
+                writer.putBytes(image.data(), image.size());
+
+                auto t0 = std::chrono::steady_clock::now();
+                if (!ipc::sendMessage(fd, writer.buffer()) || !ipc::recvMessage(fd, response)) {
+                    localFailures += requestsPerConnection - r;
+                    break;
+                }
+                auto t1 = std::chrono::steady_clock::now();
+
+                ipc::Reader reader(response);
+                uint8_t status = reader.getU8();
+                uint32_t count = reader.getU32();
+                if (!reader.ok() || status != STATUS_OK) {
+                    localFailures++;
+                    continue;
+                }
+                localFaces += count;
+                local.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+            ipc::closeSocket(fd);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+            failures += localFailures;
+            facesReturned += localFaces;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // 3) 查询服务端批处理参数与统计
+    uint32_t maxBatch = 0, maxWait = 0;
+    double meanBatch = 0.0;
+    int fd = ipc::connectUnix(socketPath);
+    if (fd >= 0) {
+        ipc::Writer writer;
+        writer.putU8(REQUEST_STATS);
+        std::vector<uint8_t> response;
+        if (ipc::sendMessage(fd, writer.buffer()) && ipc::recvMessage(fd, response)) {
+            ipc::Reader reader(response);
+            reader.getU8();
+            maxBatch = reader.getU32();
+            maxWait = reader.getU32();
+            reader.getF64(); // 请求数
+            reader.getF64(); // 批次数
+            meanBatch = reader.getF64();
+        }
+        ipc::closeSocket(fd);
+    }
+
+    cout << "[LoadClient] 完成请求: " << latencies.size() << ", 失败: " << failures
+         << ", 返回人脸: " << facesReturned << endl;
+    cout << "max_batch,max_wait_ms,connections,requests,throughput_rps,mean_ms,p50_ms,p95_ms,p99_ms,server_mean_batch" << endl;
+
+    double mean = 0.0;
+    for (double l : latencies) mean += l;
+    mean = latencies.empty() ? 0.0 : mean / latencies.size();
+
+    cout << fixed << setprecision(3)
+         << maxBatch << "," << maxWait << "," << connections << "," << latencies.size() << ","
+         << latencies.size() / elapsed << "," << mean << ","
+         << percentile(latencies, 0.50) << "," << percentile(latencies, 0.95) << ","
+         << percentile(latencies, 0.99) << "," << meanBatch << endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "face_manager.h"
+#include "face_recognition.h"
+#include "recognition_engine.h"
+#include "utils.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 丢弃输出的流缓冲，计时期间屏蔽逐帧日志
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// 将pictures目录中的前4张照片拼成2×2的测试帧，使每帧包含多张人脸
+cv::Mat buildMosaic(const std::string& dir) {
+    std::vector<cv::Mat> tiles;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (!entry.is_regular_file() || (ext != ".jpg" && ext != ".jpeg" && ext != ".png" && ext != ".bmp")) {
+            continue;
+        }
+        cv::Mat image = cv::imread(entry.path().string());
+        if (image.empty()) {
+            continue;
+        }
+        cv::resize(image, image, cv::Size(640, 480));
+        tiles.push_back(image);
+        if (tiles.size() == 4) {
+            break;
+        }
+    }
+    if (tiles.empty()) {
+        return cv::Mat();
+    }
+    while (tiles.size() < 4) {
+        tiles.push_back(tiles[0].clone());
+    }
+
+    cv::Mat top, bottom, mosaic;
+    cv::hconcat(tiles[0], tiles[1], top);
+    cv::hconcat(tiles[2], tiles[3], bottom);
+    cv::vconcat(top, bottom, mosaic);
+    return mosaic;
+}
+
+struct RunResult {
+    double sync_ms = 0.0;     // 单路同步处理每帧耗时
+    double async_fps = 0.0;   // 异步流水线吞吐量
+};
+
+// 同步逐帧处理测延迟，再以 2×线程数 的在途帧异步处理测吞吐量
+RunResult runConfig(const cv::Mat& frame, const FaceManager& manager, int frames,
+                    size_t threads, const ParallelOptions* parallel) {
+    RunResult result;
+    RecognitionEngine engine;
+    engine.initialize();
+    if (parallel) {
+        engine.configureParallel(*parallel);
+    } else {
+        cv::setNumThreads(-1); // OpenCV 默认线程数
+    }
+
+    const auto& features = manager.getKnownFeatures();
+    const auto& labels = manager.getKnownLabels();
+
+    engine.processFrame(frame, features, labels); // 预热
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) {
+        engine.processFrame(frame, features, labels);
+    }
+    result.sync_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count() / frames;
+
+    AsyncOptions async;
+    async.worker_threads = threads;
+    async.max_in_flight = threads * 2;
+    async.overflow = AsyncOverflowPolicy::BLOCK;
+    engine.configureAsync(async);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) {
+        engine.processFrameAsync(frame, manager.getIdentities(), FrameCallback());
+    }
+    engine.waitAsyncIdle();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.async_fps = seconds > 0.0 ? frames / seconds : 0.0;
+    return result;
+}
+
+} // namespace
+
+// 并行扩展性基准：线程数从1到N，对比默认配置（OpenCV默认线程数 + 独立的异步线程池）
+// 与统一线程预算（引擎线程池与OpenCV内部线程共用同一预算，可绑定CPU）
+//   --frames <n>            每种配置处理的帧数（默认40）
+//   --max-threads <n>       最大线程数（默认可用CPU数）
+//   --affinity <mode>       统一配置的CPU绑定：none / core / numa（默认core）
+int main(int argc, char** argv)
+{
+    int frames = 40;
+    size_t maxThreads = ThreadPool::availableCpus().size();
+    AffinityMode affinity = AffinityMode::CORE;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--frames") frames = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--max-threads") maxThreads = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (arg == "--affinity") {
+            std::string mode = argv[++i];
+            if (mode == "none") affinity = AffinityMode::NONE;
+            else if (mode == "core") affinity = AffinityMode::CORE;
+            else if (mode == "numa") affinity = AffinityMode::NUMA;
+            else {
+                cerr << "未知的绑定方式: " << mode << endl;
+                return -1;
+            }
+        } else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+
+    // 1) 准备模型、图库与测试帧
+    if (!load_model()) {
+        cerr << "错误：无法加载人脸识别模型" << endl;
+        return -1;
+    }
+    FaceManager manager;
+    std::string picturesDir = ::utils::getPicturesDirectory();
+    if (!manager.initialize(picturesDir) || !manager.autoScanAndRegister()) {
+        cerr << "错误：无法注册pictures目录中的人脸" << endl;
+        return -1;
+    }
+    cv::Mat frame = buildMosaic(picturesDir);
+    if (frame.empty()) {
+        cerr << "错误：pictures目录中没有可用的图像" << endl;
+        return -1;
+    }
+
+    auto nodes = ThreadPool::numaNodes();
+    cout << "[ParallelBenchmark] 可用CPU: " << ThreadPool::availableCpus().size()
+         << ", NUMA节点: " << nodes.size() << ", 测试帧: " << frame.cols << "x" << frame.rows
+         << ", 每种配置 " << frames << " 帧" << endl;
+
+    // 2) 逐个线程数运行两种配置
+    std::vector<size_t> threadCounts;
+    for (size_t n = 1; n < maxThreads; n *= 2) {
+        threadCounts.push_back(n);
+    }
+    threadCounts.push_back(maxThreads);
+
+    NullBuffer nullBuffer;
+    std::streambuf* coutBuffer = cout.rdbuf();
+    double baselineFps = 0.0;
+
+    cout << left << setw(9) << "threads" << setw(10) << "config"
+         << setw(12) << "sync_ms" << setw(12) << "async_fps" << setw(10) << "speedup" << endl;
+    for (size_t n : threadCounts) {
+        ParallelOptions unified;
+        unified.threads = n;
+        unified.affinity = affinity;
+        unified.detection = ParallelPolicy::INTRA_OPENCV;
+        unified.extraction = ParallelPolicy::INTER_FACE;
+
+        cout.rdbuf(&nullBuffer);
+        RunResult defaults = runConfig(frame, manager, frames, n, nullptr);
+        RunResult tuned = runConfig(frame, manager, frames, n, &unified);
+        cout.rdbuf(coutBuffer);
+
+        if (baselineFps == 0.0) {
+            baselineFps = defaults.async_fps;
+        }
+        for (int c = 0; c < 2; ++c) {
+            const RunResult& r = c == 0 ? defaults : tuned;
+            cout << left << fixed << setprecision(2)
+                 << setw(9) << n << setw(10) << (c == 0 ? "default" : "unified")
+                 << setw(12) << r.sync_ms << setw(12) << r.async_fps
+                 << setw(10) << (baselineFps > 0.0 ? r.async_fps / baselineFps : 0.0) << endl;
+        }
+    }
+
+    cout << "[ParallelBenchmark] default: OpenCV默认线程数，异步线程池按线程数创建；"
+         << "unified: 引擎线程池与OpenCV内部线程共用线程预算" << endl;
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "label_table.h"
+#include "shard_service.h"
+
+using namespace std;
+
+// 分片图库基准测试：随分片数量增加，统计查询延迟
+//   --identities <n>   图库身份数量（默认200000）
+//   --queries <n>      每种配置的查询次数（默认200）
+//   --max-shards <n>   最大分片数量（默认为CPU核数）
+//   --top-k <n>        每次查询返回的结果数（默认5）
+//   --timeout-ms <n>   单次查询超时（默认1000）
+int main(int argc, char** argv)
+{
+    size_t identities = 200000;
+    size_t queries = 200;
+    int maxShards = (int)std::max(1u, std::thread::hardware_concurrency());
+    size_t topK = 5;
+    int timeoutMs = 1000;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--identities") identities = std::stoul(argv[++i]);
+        else if (arg == "--queries") queries = std::stoul(argv[++i]);
+        else if (arg == "--max-shards") maxShards = std::stoi(argv[++i]);
+        else if (arg == "--top-k") topK = std::stoul(argv[++i]);
+        else if (arg == "--timeout-ms") timeoutMs = std::stoi(argv[++i]);
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+
+    // 1) 生成随机图库（128维，与特征提取器一致）
+    cout << "[ShardBench] 生成 " << identities << " 个随机身份..." << endl;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    std::vector<cv::Mat> features;
+    std::vector<std::string> labels;
+    features.reserve(identities);
+    labels.reserve(identities);
+    for (size_t i = 0; i < identities; ++i) {
+        cv::Mat f(1, 128, CV_32F);
+        for (int d = 0; d < 128; ++d) {
+            f.at<float>(0, d) = dist(rng);
+        }
+        features.push_back(f);
+        labels.push_back("id_" + std::to_string(i));
+    }
+
+    // 查询取自图库本身，便于校验合并后的结果
+    std::vector<size_t> queryIndices(queries);
+    std::uniform_int_distribution<size_t> pick(0, identities - 1);
+    for (auto& q : queryIndices) {
+        q = pick(rng);
+    }
+
+    cout << left << setw(8) << "shards" << setw(12) << "mean(ms)" << setw(12) << "p50(ms)"
+         << setw(12) << "p99(ms)" << setw(12) << "qps" << setw(10) << "correct" << endl;
+
+    // 2) 分片数量按 1, 2, 4, ... 递增
+    for (int shards = 1; shards <= maxShards; shards *= 2) {
+        ShardCoordinator coordinator;
+        coordinator.setTimeoutMs(timeoutMs);
+        if (!coordinator.start(features, labels, shards)) {
+            cerr << "[ShardBench] 无法启动 " << shards << " 个分片" << endl;
+            return -1;
+        }
+
+        std::vector<ShardMatch> matches;
+        coordinator.query(features[queryIndices[0]], topK, matches); // 预热
+
+        std::vector<double> latencies;
+        size_t correct = 0;
+        auto total_start = std::chrono::steady_clock::now();
+        for (size_t q : queryIndices) {
+            auto start = std::chrono::steady_clock::now();
+            bool ok = coordinator.query(features[q], topK, matches);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            if (ok && !matches.empty() && LabelTable::global().name(matches[0].label_id) == labels[q]) {
+                correct++;
+            }
+        }
+        double total_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - total_start).count();
+
+        std::sort(latencies.begin(), latencies.end());
+        double mean = 0.0;
+        for (double l : latencies) mean += l;
+        mean /= latencies.size();
+        double p50 = latencies[latencies.size() / 2];
+        double p99 = latencies[std::min(latencies.size() - 1, (size_t)(latencies.size() * 0.99))];
+
+        cout << left << fixed << setprecision(3)
+             << setw(8) << shards << setw(12) << mean << setw(12) << p50
+             << setw(12) << p99 << setw(12) << setprecision(1) << queries / total_s
+             << setw(10) << (std::to_string(correct) + "/" + std::to_string(queries)) << endl;
+
+        coordinator.printStats();
+        coordinator.stop();
+    }
+
+    return 0;
+}
@@ -0,0 +1,480 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "face_detection.h"
+#include "face_recognition.h"
+#include "feature_matrix.h"
+#include "recognition_engine.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 丢弃输出的流缓冲，提取与探测期间屏蔽逐图/逐次日志
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct LabeledFile {
+    std::string path;
+    std::string label;
+};
+
+// 与 FaceManager 扫描规则一致：子目录名为标签；根目录下的文件按 labels.txt 映射，否则取文件名（去扩展名）
+std::vector<LabeledFile> collectImages(const std::string& dir) {
+    auto isSupportedImage = [](const fs::path& p) {
+        std::string ext = p.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp";
+    };
+
+    std::unordered_map<std::string, std::string> mapping;
+    std::ifstream mappingFile((fs::path(dir) / "labels.txt").string());
+    std::string line;
+    while (std::getline(mappingFile, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string filename, label;
+        if (fields >> filename >> label) {
+            mapping[filename] = label;
+        }
+    }
+
+    std::vector<LabeledFile> files;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.is_directory()) {
+            std::string label = entry.path().filename().string();
+            for (const auto& sample : fs::directory_iterator(entry.path())) {
+                if (sample.is_regular_file() && isSupportedImage(sample.path())) {
+                    files.push_back({sample.path().string(), label});
+                }
+            }
+        } else if (entry.is_regular_file() && isSupportedImage(entry.path())) {
+            auto mapped = mapping.find(entry.path().filename().string());
+            files.push_back({entry.path().string(),
+                             mapped != mapping.end() ? mapped->second : entry.path().stem().string()});
+        }
+    }
+    std::sort(files.begin(), files.end(),
+              [](const LabeledFile& a, const LabeledFile& b) { return a.path < b.path; });
+    return files;
+}
+
+// 合成数据：每个身份一个随机中心，样本 = 中心 + noise × 高斯噪声（同身份期望相似度约 1 / (1 + noise²)）
+void buildSynthetic(size_t identities, size_t samples, float noise, int dimension,
+                    std::vector<float>& features, std::vector<std::string>& labels) {
+    std::mt19937 rng(42);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<float> center(dimension);
+    features.resize(identities * samples * dimension);
+    labels.resize(identities * samples);
+
+    for (size_t id = 0; id < identities; ++id) {
+        for (int d = 0; d < dimension; ++d) {
+            center[d] = normal(rng);
+        }
+        for (size_t s = 0; s < samples; ++s) {
+            size_t index = id * samples + s;
+            float* row = features.data() + index * dimension;
+            for (int d = 0; d < dimension; ++d) {
+                row[d] = center[d] + noise * normal(rng);
+            }
+            labels[index] = "id_" + std::to_string(id);
+        }
+    }
+}
+
+// 同身份（genuine）与不同身份（impostor）比对分数的直方图，分数范围 [-1, 1]
+struct ScoreHistogram {
+    std::vector<uint64_t> genuine;
+    std::vector<uint64_t> impostor;
+
+    explicit ScoreHistogram(size_t bins = 0) : genuine(bins, 0), impostor(bins, 0) {}
+
+    void merge(const ScoreHistogram& other) {
+        for (size_t b = 0; b < genuine.size(); ++b) {
+            genuine[b] += other.genuine[b];
+            impostor[b] += other.impostor[b];
+        }
+    }
+};
+
+// 标准正态分布的分位数（Acklam 有理逼近，相对误差约 1e-9），用于 DET 曲线的正态偏差坐标
+double probit(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double low = 0.02425;
+
+    p = std::min(std::max(p, 1e-12), 1.0 - 1e-12);
+    if (p < low) {
+        double q = std::sqrt(-2.0 * std::log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    if (p > 1.0 - low) {
+        double q = std::sqrt(-2.0 * std::log(1.0 - p));
+        return -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+// 用构造好的二维特征探测 RecognitionEngine::matchFace 的接受规则：
+// 查询 (1, 0) 与图库 (s, sqrt(1 - s²)) 的余弦相似度恰为 s，返回值不是 Unknown 即视为接受
+std::vector<bool> probeEngineDecision(const std::vector<double>& similarities) {
+    RecognitionEngine engine;
+    std::vector<std::string> labels = {"probe"};
+    cv::Mat query(1, 2, CV_32F);
+    query.at<float>(0, 0) = 1.0f;
+    query.at<float>(0, 1) = 0.0f;
+    std::vector<bool> accepted(similarities.size(), false);
+
+    NullBuffer null;
+    std::streambuf* saved = cout.rdbuf(&null);
+    for (size_t k = 0; k < similarities.size(); ++k) {
+        double s = std::min(1.0, std::max(-1.0, similarities[k]));
+        cv::Mat gallery(1, 2, CV_32F);
+        gallery.at<float>(0, 0) = (float)s;
+        gallery.at<float>(0, 1) = (float)std::sqrt(std::max(0.0, 1.0 - s * s));
+        accepted[k] = engine.matchFace(query, {gallery}, labels) != "Unknown";
+    }
+    cout.rdbuf(saved);
+    return accepted;
+}
+
+} // namespace
+
+// 1:1 验证评测：并行提取模板，用分块相似度内核计算全部样本对的 genuine / impostor 分数分布，
+// 输出 ROC / DET 曲线、目标 FAR 下的阈值与 EER，并给出 matchFace 多阈值策略实际对应的工作点
+//   --images <dir>          带标签的图片目录（默认pictures，标签规则与 FaceManager 相同）
+//   --synthetic <n>         使用n个合成身份代替图片（测试规模与速度）
+//   --samples <k>           合成模式下每个身份的样本数（默认10）
+//   --noise <sigma>         合成模式下样本噪声（默认0.6）
+//   --threads <n>           线程数（默认可用CPU数）
+//   --block <n>             相似度分块大小（默认128）
+//   --bins <n>              分数直方图分桶数（默认20000，分辨率 2 / n）
+//   --output <prefix>       输出 <prefix>_roc.csv、<prefix>_det.csv 和 <prefix>.json（默认verification）
+int main(int argc, char** argv)
+{
+    std::string imagesDir;
+    size_t synthetic = 0;
+    size_t samples = 10;
+    float noise = 0.6f;
+    size_t threads = 0;
+    size_t block = 128;
+    size_t bins = 20000;
+    std::string outputPrefix = "verification";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--images") imagesDir = argv[++i];
+        else if (arg == "--synthetic") synthetic = std::stoul(argv[++i]);
+        else if (arg == "--samples") samples = std::max<size_t>(2, std::stoul(argv[++i]));
+        else if (arg == "--noise") noise = std::stof(argv[++i]);
+        else if (arg == "--threads") threads = std::stoul(argv[++i]);
+        else if (arg == "--block") block = std::stoul(argv[++i]);
+        else if (arg == "--bins") bins = std::max<size_t>(100, std::stoul(argv[++i]));
+        else if (arg == "--output") outputPrefix = argv[++i];
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+    if (imagesDir.empty()) {
+        imagesDir = ::utils::getPicturesDirectory();
+    }
+    if (!load_model()) {
+        cerr << "错误：无法加载人脸识别模型" << endl;
+        return -1;
+    }
+
+    ThreadPool pool(threads);
+
+    // 1) 模板：合成数据，或逐张图片并行检测 + 提取（取最大人脸）
+    auto extractStart = std::chrono::steady_clock::now();
+    FeatureMatrix matrix;
+    std::vector<std::string> labels;
+    size_t failed = 0;
+
+    if (synthetic > 0) {
+        std::vector<float> features;
+        buildSynthetic(synthetic, samples, noise, 128, features, labels);
+        matrix = FeatureMatrix::fromRows(features.data(), labels.size(), 128);
+    } else {
+        std::vector<LabeledFile> files = collectImages(imagesDir);
+        std::vector<cv::Mat> templates(files.size());
+
+        NullBuffer null;
+        std::streambuf* saved = cout.rdbuf(&null);
+        pool.parallelFor(files.size(), [&](size_t i) {
+            cv::Mat image = cv::imread(files[i].path);
+            if (image.empty()) {
+                return;
+            }
+            std::vector<cv::Rect> faces = detectFaces(image);
+            if (faces.empty()) {
+                return;
+            }
+            cv::Rect largest = *std::max_element(faces.begin(), faces.end(),
+                [](const cv::Rect& a, const cv::Rect& b) { return a.area() < b.area(); });
+            std::vector<cv::Mat> features = extract_face_features(image, {largest});
+            if (features.size() == 1) {
+                templates[i] = features[0];
+            }
+        });
+        cout.rdbuf(saved);
+
+        std::vector<cv::Mat> extracted;
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (templates[i].empty()) {
+                cerr << "[VerificationEval] 未能提取模板: " << files[i].path << endl;
+                failed++;
+                continue;
+            }
+            extracted.push_back(templates[i]);
+            labels.push_back(files[i].label);
+        }
+        matrix = FeatureMatrix::fromMats(extracted);
+    }
+    double extractSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - extractStart).count();
+
+    if (matrix.rows() < 2) {
+        cerr << "[VerificationEval] 模板数量不足，无法评测" << endl;
+        return -1;
+    }
+
+    // 标签映射为整数，内层循环只比较整数
+    std::vector<uint32_t> labelIds(labels.size());
+    std::map<std::string, uint32_t> labelIndex;
+    for (size_t i = 0; i < labels.size(); ++i) {
+        labelIds[i] = labelIndex.emplace(labels[i], (uint32_t)labelIndex.size()).first->second;
+    }
+
+    cout << "[VerificationEval] 模板: " << matrix.rows() << " × " << matrix.dimension()
+         << ", 身份: " << labelIndex.size() << ", 提取失败: " << failed
+         << ", 线程: " << pool.size() << ", 提取耗时: " << std::fixed << std::setprecision(2)
+         << extractSeconds << " s" << endl;
+
+    // 2) 全部样本对打分，每个线程累加自己的直方图，结束后合并
+    std::mutex histogramMutex;
+    std::map<std::thread::id, ScoreHistogram> perThread;
+    const double binScale = bins / 2.0;
+
+    AllPairsStats stats = forEachTile(matrix, pool,
+        [&](size_t a_begin, size_t a_end, size_t b_begin, size_t b_end, const float* scores) {
+            ScoreHistogram* histogram;
+            {
+                std::lock_guard<std::mutex> lock(histogramMutex);
+                auto it = perThread.find(std::this_thread::get_id());
+                if (it == perThread.end()) {
+                    it = perThread.emplace(std::this_thread::get_id(), ScoreHistogram(bins)).first;
+                }
+                histogram = &it->second;
+            }
+
+            // 捕获量拷贝到局部变量，避免计数写入后重新加载
+            uint64_t* genuine = histogram->genuine.data();
+            uint64_t* impostor = histogram->impostor.data();
+            const uint32_t* ids = labelIds.data();
+            const double scale = binScale;
+            const long lastBin = (long)bins - 1;
+            const size_t width = b_end - b_begin;
+            for (size_t i = a_begin; i < a_end; ++i) {
+                const float* row = scores + (i - a_begin) * width;
+                const uint32_t label = ids[i];
+                // 对角块只取 j > i
+                size_t j_begin = a_begin == b_begin ? i + 1 : b_begin;
+                for (size_t j = j_begin; j < b_end; ++j) {
+                    long bin = (long)((row[j - b_begin] + 1.0) * scale);
+                    bin = std::min<long>(std::max<long>(bin, 0), lastBin);
+                    if (ids[j] == label) {
+                        genuine[bin]++;
+                    } else {
+                        impostor[bin]++;
+                    }
+                }
+            }
+        }, block);
+
+    ScoreHistogram total(bins);
+    for (const auto& entry : perThread) {
+        total.merge(entry.second);
+    }
+    uint64_t genuinePairs = 0;
+    uint64_t impostorPairs = 0;
+    for (size_t b = 0; b < bins; ++b) {
+        genuinePairs += total.genuine[b];
+        impostorPairs += total.impostor[b];
+    }
+
+    cout << "[VerificationEval] 比对 " << stats.pairs_compared << " 对 (genuine: " << genuinePairs
+         << ", impostor: " << impostorPairs << "), 耗时 " << std::setprecision(3) << stats.seconds << " s ("
+         << std::setprecision(1) << (stats.seconds > 0.0 ? stats.pairs_compared / stats.seconds / 1e6 : 0.0)
+         << " M对/s, " << stats.gflops << " GFLOP/s)" << endl;
+    if (genuinePairs == 0 || impostorPairs == 0) {
+        cerr << "[VerificationEval] 需要同时存在同身份与不同身份的样本对（每个身份至少2个样本）" << endl;
+        return -1;
+    }
+
+    // 3) 阈值扫描：阈值取分桶下边界 t_k，分数 ≥ t_k 即接受
+    //    FAR(t_k) = 桶 ≥ k 的 impostor 占比，FRR(t_k) = 桶 < k 的 genuine 占比
+    std::vector<double> far(bins + 1), frr(bins + 1), thresholds(bins + 1);
+    uint64_t impostorAbove = impostorPairs;
+    uint64_t genuineBelow = 0;
+    for (size_t k = 0; k <= bins; ++k) {
+        thresholds[k] = k / binScale - 1.0;
+        far[k] = (double)impostorAbove / impostorPairs;
+        frr[k] = (double)genuineBelow / genuinePairs;
+        if (k < bins) {
+            impostorAbove -= total.impostor[k];
+            genuineBelow += total.genuine[k];
+        }
+    }
+
+    // EER：FAR 与 FRR 交叉处取两者均值
+    size_t eerIndex = 0;
+    while (eerIndex < bins && far[eerIndex] > frr[eerIndex]) {
+        eerIndex++;
+    }
+    double eer = (far[eerIndex] + frr[eerIndex]) / 2.0;
+    if (eerIndex > 0) {
+        double previous = (far[eerIndex - 1] + frr[eerIndex - 1]) / 2.0;
+        if (far[eerIndex - 1] - frr[eerIndex - 1] < frr[eerIndex] - far[eerIndex]) {
+            eer = previous;
+            eerIndex--;
+        }
+    }
+
+    // 目标 FAR 下的最小阈值（FAR 随阈值单调不增）；该 FAR 下期望的误接受数不足 10 次时视为无法可靠测量
+    struct OperatingPoint {
+        double target_far;
+        double threshold;
+        double far;
+        double tar;
+        bool measurable;
+    };
+    std::vector<OperatingPoint> operatingPoints;
+    for (double target : {1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6}) {
+        size_t k = 0;
+        while (k < bins && far[k] > target) {
+            k++;
+        }
+        operatingPoints.push_back({target, thresholds[k], far[k], 1.0 - frr[k], target * impostorPairs >= 10.0});
+    }
+
+    // 4) matchFace 的实际接受规则：在每个分桶中心探测一次引擎
+    std::vector<double> centers(bins);
+    for (size_t b = 0; b < bins; ++b) {
+        centers[b] = (b + 0.5) / binScale - 1.0;
+    }
+    std::vector<bool> engineAccepts = probeEngineDecision(centers);
+    uint64_t engineFalseAccepts = 0;
+    uint64_t engineFalseRejects = 0;
+    double engineMinAccepted = 2.0;
+    bool engineMonotone = true;
+    for (size_t b = 0; b < bins; ++b) {
+        if (engineAccepts[b]) {
+            engineFalseAccepts += total.impostor[b];
+            engineMinAccepted = std::min(engineMinAccepted, centers[b]);
+        } else {
+            engineFalseRejects += total.genuine[b];
+            if (engineMinAccepted <= 1.0) {
+                engineMonotone = false; // 接受区间之上又出现拒绝
+            }
+        }
+    }
+    double engineFar = (double)engineFalseAccepts / impostorPairs;
+    double engineFrr = (double)engineFalseRejects / genuinePairs;
+
+    // 5) 输出：ROC 只写 FAR 或 FRR 发生变化的阈值，DET 额外给出正态偏差坐标
+    std::ofstream roc(outputPrefix + "_roc.csv");
+    std::ofstream det(outputPrefix + "_det.csv");
+    roc << "threshold,far,frr,tar\n";
+    det << "threshold,far,frr,far_probit,frr_probit\n";
+    roc << std::setprecision(9);
+    det << std::setprecision(9);
+    for (size_t k = 0; k <= bins; ++k) {
+        if (k > 0 && k < bins && far[k] == far[k - 1] && frr[k] == frr[k - 1]) {
+            continue;
+        }
+        roc << thresholds[k] << "," << far[k] << "," << frr[k] << "," << 1.0 - frr[k] << "\n";
+        if (far[k] > 0.0 && frr[k] > 0.0) {
+            det << thresholds[k] << "," << far[k] << "," << frr[k] << ","
+                << probit(far[k]) << "," << probit(frr[k]) << "\n";
+        }
+    }
+
+    std::ofstream json(outputPrefix + ".json");
+    json << std::setprecision(9);
+    json << "{\n  \"templates\": " << matrix.rows() << ",\n  \"identities\": " << labelIndex.size()
+         << ",\n  \"extraction_failures\": " << failed
+         << ",\n  \"genuine_pairs\": " << genuinePairs << ",\n  \"impostor_pairs\": " << impostorPairs
+         << ",\n  \"extract_seconds\": " << extractSeconds << ",\n  \"score_seconds\": " << stats.seconds
+         << ",\n  \"eer\": " << eer << ",\n  \"eer_threshold\": " << thresholds[eerIndex]
+         << ",\n  \"operating_points\": [\n";
+    for (size_t p = 0; p < operatingPoints.size(); ++p) {
+        const auto& point = operatingPoints[p];
+        json << "    {\"target_far\": " << point.target_far << ", \"threshold\": " << point.threshold
+             << ", \"far\": " << point.far << ", \"tar\": " << point.tar
+             << ", \"measurable\": " << (point.measurable ? "true" : "false") << "}"
+             << (p + 1 < operatingPoints.size() ? ",\n" : "\n");
+    }
+    json << "  ],\n  \"engine\": {\"effective_threshold\": " << (engineMinAccepted <= 1.0 ? engineMinAccepted : 1.0)
+         << ", \"monotone\": " << (engineMonotone ? "true" : "false")
+         << ", \"far\": " << engineFar << ", \"frr\": " << engineFrr << "}\n}\n";
+
+    // 6) 汇总
+    cout << "[VerificationEval] EER: " << std::setprecision(4) << eer * 100.0 << "% @ 阈值 "
+         << thresholds[eerIndex] << endl;
+    cout << "[VerificationEval] 目标FAR        阈值     实际FAR        TAR" << endl;
+    for (const auto& point : operatingPoints) {
+        cout << "  " << std::scientific << std::setprecision(0) << point.target_far << std::fixed;
+        if (!point.measurable) {
+            cout << "    (impostor 对不足，无法测量)" << endl;
+            continue;
+        }
+        cout << "    " << std::setw(8) << std::setprecision(4) << point.threshold
+             << "   " << std::scientific << std::setprecision(2) << point.far << std::fixed
+             << "   " << std::setprecision(4) << point.tar << endl;
+    }
+    cout << "[VerificationEval] matchFace 多阈值策略: 实际接受相似度 ≥ " << std::setprecision(4)
+         << engineMinAccepted << (engineMonotone ? "（等价于单一阈值）" : "（接受区间不连续）")
+         << ", FAR " << std::scientific << std::setprecision(2) << engineFar
+         << ", FRR " << engineFrr << std::fixed << endl;
+    cout << "[VerificationEval] 结果已写入 " << outputPrefix << "_roc.csv / " << outputPrefix
+         << "_det.csv / " << outputPrefix << ".json" << endl;
+    return 0;
+}
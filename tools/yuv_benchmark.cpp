@@ -0,0 +1,245 @@
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "face_recognition.h"
+#include "recognition_engine.h"
+#include "utils.h"
+#include "yuv_frame.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 丢弃输出的流缓冲，计时期间屏蔽逐帧日志
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// 将目录中的前4张照片拼成2×2的BGR测试帧（尺寸为 size），使每帧包含多张人脸
+cv::Mat buildMosaic(const std::string& dir, const cv::Size& size) {
+    std::vector<cv::Mat> tiles;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (!entry.is_regular_file() || (ext != ".jpg" && ext != ".jpeg" && ext != ".png" && ext != ".bmp")) {
+            continue;
+        }
+        cv::Mat image = cv::imread(entry.path().string());
+        if (image.empty()) {
+            continue;
+        }
+        cv::resize(image, image, cv::Size(size.width / 2, size.height / 2));
+        tiles.push_back(image);
+        if (tiles.size() == 4) {
+            break;
+        }
+    }
+    if (tiles.empty()) {
+        return cv::Mat();
+    }
+    while (tiles.size() < 4) {
+        tiles.push_back(tiles[0].clone());
+    }
+
+    cv::Mat top, bottom, mosaic;
+    cv::hconcat(tiles[0], tiles[1], top);
+    cv::hconcat(tiles[2], tiles[3], bottom);
+    cv::vconcat(top, bottom, mosaic);
+    return mosaic;
+}
+
+// BGR 转为 OpenCV 单缓冲区布局的 NV12/I420（height*3/2 行）
+cv::Mat encodeYuv(const cv::Mat& bgr, YuvLayout layout) {
+    cv::Mat i420;
+    cv::cvtColor(bgr, i420, cv::COLOR_BGR2YUV_I420);
+    if (layout == YuvLayout::I420) {
+        return i420;
+    }
+
+    // I420 -> NV12：亮度不变，U、V 交错
+    const int width = bgr.cols;
+    const int height = bgr.rows;
+    const size_t chroma_size = (size_t)(width / 2) * (height / 2);
+    cv::Mat nv12(height * 3 / 2, width, CV_8UC1);
+    std::memcpy(nv12.data, i420.data, (size_t)width * height);
+    const uint8_t* u = i420.data + (size_t)width * height;
+    const uint8_t* v = u + chroma_size;
+    uint8_t* uv = nv12.data + (size_t)width * height;
+    for (size_t i = 0; i < chroma_size; ++i) {
+        uv[2 * i] = u[i];
+        uv[2 * i + 1] = v[i];
+    }
+    return nv12;
+}
+
+std::vector<cv::Size> parseSizes(const std::string& text) {
+    std::vector<cv::Size> sizes;
+    std::istringstream fields(text);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        size_t x = field.find('x');
+        if (x == std::string::npos) {
+            continue;
+        }
+        // 4:2:0 要求宽高为偶数
+        sizes.push_back(cv::Size(std::stoi(field.substr(0, x)) & ~1, std::stoi(field.substr(x + 1)) & ~1));
+    }
+    return sizes;
+}
+
+template <typename Fn>
+double bestMs(int repeat, Fn fn) {
+    double best = 0.0;
+    for (int r = 0; r < repeat; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = r == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+} // namespace
+
+// YUV 输入基准：对比“整帧转BGR再处理”与“亮度平面检测 + 只转换人脸区域”两条路径
+//   --sizes <list>          帧尺寸列表（默认1920x1080,3840x2160）
+//   --layout <nv12|i420>    YUV 格式（默认nv12）
+//   --images <dir>          拼接测试帧的照片目录（默认pictures目录）
+//   --frames <n>            端到端计时的帧数（默认20）
+//   --repeat <n>            转换阶段重复次数，取最快一次（默认5）
+//
+// 转换读写量按字节估算：整帧路径为 YUV→BGR（读1.5、写3 字节/像素）加 BGR→灰度（读3、写1 字节/像素）；
+// 亮度平面路径整帧为 0，只有人脸区域读 YUV、写 BGR（I420 另有一次区域打包）
+int main(int argc, char** argv)
+{
+    std::vector<cv::Size> sizes = {cv::Size(1920, 1080), cv::Size(3840, 2160)};
+    std::string layoutName = "nv12";
+    std::string imagesDir;
+    int frames = 20;
+    int repeat = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return -1;
+        }
+        if (arg == "--sizes") sizes = parseSizes(argv[++i]);
+        else if (arg == "--layout") layoutName = argv[++i];
+        else if (arg == "--images") imagesDir = argv[++i];
+        else if (arg == "--frames") frames = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--repeat") repeat = std::max(1, std::stoi(argv[++i]));
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return -1;
+        }
+    }
+    if (layoutName != "nv12" && layoutName != "i420") {
+        cerr << "未知的 YUV 格式: " << layoutName << endl;
+        return -1;
+    }
+    if (sizes.empty()) {
+        cerr << "错误：帧尺寸列表为空" << endl;
+        return -1;
+    }
+    const YuvLayout layout = layoutName == "nv12" ? YuvLayout::NV12 : YuvLayout::I420;
+    const cv::ColorConversionCodes toBgr = layout == YuvLayout::NV12 ? cv::COLOR_YUV2BGR_NV12 : cv::COLOR_YUV2BGR_I420;
+    if (imagesDir.empty()) {
+        imagesDir = ::utils::getPicturesDirectory();
+    }
+
+    if (!load_model()) {
+        cerr << "错误：无法加载人脸识别模型" << endl;
+        return -1;
+    }
+    RecognitionEngine engine;
+    engine.initialize();
+    const std::vector<cv::Mat> knownFeatures;
+    const std::vector<uint32_t> knownLabelIds;
+    RecognitionResults results;
+
+    NullBuffer nullBuffer;
+    std::streambuf* coutBuffer = cout.rdbuf();
+
+    cout << "[YuvBenchmark] 格式: " << layoutName << ", 端到端 " << frames << " 帧, 转换阶段重复 " << repeat
+         << " 次取最快" << endl;
+    cout << left << setw(12) << "size" << setw(10) << "path" << setw(8) << "faces" << setw(14) << "convert_ms"
+         << setw(14) << "convert_MB" << setw(12) << "frame_ms" << setw(10) << "speedup" << endl;
+
+    for (const cv::Size& size : sizes) {
+        cv::Mat mosaic = buildMosaic(imagesDir, size);
+        if (mosaic.empty()) {
+            cerr << "错误：目录中没有可用的图片: " << imagesDir << endl;
+            return -1;
+        }
+        cv::Mat buffer = encodeYuv(mosaic, layout);
+        YuvFrame frame = YuvFrame::wrap(buffer, layout);
+        const double pixels = (double)size.area();
+
+        // 1) 整帧路径：YUV→BGR，检测内部再 BGR→灰度
+        cv::Mat bgr, gray;
+        double fullConvertMs = bestMs(repeat, [&] {
+            cv::cvtColor(buffer, bgr, toBgr);
+            cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+        });
+        double fullConvertMB = pixels * (1.5 + 3.0 + 3.0 + 1.0) / 1048576.0;
+
+        cout.rdbuf(&nullBuffer);
+        engine.processFrame(bgr, knownFeatures, knownLabelIds, results); // 预热
+        double fullFrameMs = bestMs(1, [&] {
+            for (int f = 0; f < frames; ++f) {
+                cv::cvtColor(buffer, bgr, toBgr);
+                engine.processFrame(bgr, knownFeatures, knownLabelIds, results);
+            }
+        }) / frames;
+        size_t fullFaces = results.size();
+
+        // 2) 亮度平面路径：检测不转换，只转换检测到的人脸区域
+        engine.processFrame(frame, knownFeatures, knownLabelIds, results); // 预热
+        double lumaFrameMs = bestMs(1, [&] {
+            for (int f = 0; f < frames; ++f) {
+                engine.processFrame(frame, knownFeatures, knownLabelIds, results);
+            }
+        }) / frames;
+        cout.rdbuf(coutBuffer);
+        size_t lumaFaces = results.size();
+
+        std::vector<cv::Rect> faces;
+        for (const auto& result : results) {
+            faces.push_back(result.rect);
+        }
+        cv::Mat crop;
+        double lumaConvertMs = bestMs(repeat, [&] {
+            for (const auto& face : faces) {
+                yuvCropToBgr(frame, face, crop);
+            }
+        });
+        double cropPixels = 0.0;
+        for (const auto& face : faces) {
+            cropPixels += face.area();
+        }
+        double lumaConvertMB = cropPixels * (layout == YuvLayout::I420 ? 1.5 + 1.5 + 3.0 : 1.5 + 3.0) / 1048576.0;
+
+        std::string sizeName = std::to_string(size.width) + "x" + std::to_string(size.height);
+        cout << left << fixed << setw(12) << sizeName << setw(10) << "bgr" << setw(8) << fullFaces
+             << setw(14) << setprecision(2) << fullConvertMs << setw(14) << setprecision(1) << fullConvertMB
+             << setw(12) << setprecision(2) << fullFrameMs << setw(10) << 1.0 << endl;
+        cout << left << fixed << setw(12) << "" << setw(10) << "luma" << setw(8) << lumaFaces
+             << setw(14) << setprecision(2) << lumaConvertMs << setw(14) << setprecision(1) << lumaConvertMB
+             << setw(12) << setprecision(2) << lumaFrameMs << setw(10) << fullFrameMs / lumaFrameMs << endl;
+    }
+
+    cout << "[YuvBenchmark] convert_ms/convert_MB 为每帧颜色转换的耗时与估算读写量，frame_ms 为端到端单帧耗时；"
+         << "两条路径检测到的人脸数应一致（亮度平面与BGR转灰度只差一个线性映射，直方图均衡化后基本相同）" << endl;
+    return 0;
+}